@@ -1,10 +1,12 @@
 #include "devices/swap.h"
 #include "devices/block.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include <bitmap.h>
 #include <debug.h>
 #include <stdio.h>
+#include <string.h>
 
 /* Pointer to the swap device */
 static struct block *swap_device;
@@ -18,6 +20,13 @@ static struct lock swap_lock;
 /* Number of sectors needed to store a page */
 #define PAGE_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
 
+/* Buffer of SWAP_CLUSTER pages, through which a cluster of pages
+   in separate frames is copied so that it can be transferred to
+   or from consecutive swap-slots in a single request, and the
+   lock that serialises its use */
+static uint8_t *cluster_buffer;
+static struct lock cluster_lock;
+
 /* Sets up the swap space */
 void
 swap_init (void) 
@@ -36,26 +45,20 @@ swap_init (void)
     PANIC ("couldn't create swap bitmap");
   }
   lock_init (&swap_lock);
+
+  cluster_buffer = palloc_get_multiple (PAL_ASSERT, SWAP_CLUSTER);
+  lock_init (&cluster_lock);
 }
 
 /* Swaps page at VADDR out of memory, returns the swap-slot used */
 size_t
 swap_out (const void *vaddr) 
 {
-  // find available swap-slot for the page to be swapped out
-  lock_acquire (&swap_lock);
-  size_t slot = bitmap_scan_and_flip (swap_bitmap, 0, 1, false);
-  lock_release (&swap_lock);
+  size_t slot = swap_alloc (1);
   if (slot == BITMAP_ERROR) 
     return BITMAP_ERROR; 
 
-  // calculate block sector from swap-slot number
-  size_t sector = slot * PAGE_SECTORS;
-  
-  // loop over each sector of the page, copying it from memory into swap
-  for (size_t i = 0; i < PAGE_SECTORS; i++)
-    block_write (swap_device, sector + i, vaddr + i * BLOCK_SECTOR_SIZE);
-
+  swap_write (slot, vaddr);
   return slot;
 }
 
@@ -63,17 +66,93 @@ swap_out (const void *vaddr)
 void
 swap_in (void *vaddr, size_t slot) 
 {
-  // calculate block sector from swap-slot number
-  size_t sector = slot * PAGE_SECTORS;
-
-  // loop over each sector of the page, copying it from swap into memory
-  for (size_t i = 0; i < PAGE_SECTORS; i++)
-    block_read (swap_device, sector + i, vaddr + i * BLOCK_SECTOR_SIZE);
+  swap_read (slot, vaddr);
   
   // clear the swap-slot previously used by this page
   swap_drop (slot);
 }
 
+/* Reserves CNT consecutive swap-slots, so that a cluster of pages
+   can be written out, and later read back in, without seeking
+   between them.  Returns the first slot, or BITMAP_ERROR if there
+   is no free run that long. */
+size_t
+swap_alloc (size_t cnt)
+{
+  lock_acquire (&swap_lock);
+  size_t slot = bitmap_scan_and_flip (swap_bitmap, 0, cnt, false);
+  lock_release (&swap_lock);
+  return slot;
+}
+
+/* Writes the page at VADDR to swap-slot SLOT, which must have
+   been reserved by swap_alloc(), in a single request */
+void
+swap_write (size_t slot, const void *vaddr)
+{
+  block_write_multiple (swap_device, slot * PAGE_SECTORS, PAGE_SECTORS,
+                        vaddr);
+}
+
+/* Reads the page in swap-slot SLOT into memory at VADDR, in a
+   single request, leaving the slot reserved */
+void
+swap_read (size_t slot, void *vaddr)
+{
+  block_read_multiple (swap_device, slot * PAGE_SECTORS, PAGE_SECTORS,
+                       vaddr);
+}
+
+/* Writes the CNT pages in PAGES to the CNT consecutive swap-slots
+   starting at SLOT, which must have been reserved by swap_alloc(),
+   in a single request for each SWAP_CLUSTER of them */
+void
+swap_write_cluster (size_t slot, size_t cnt, void *const pages[])
+{
+  size_t i, n;
+
+  if (cnt == 1) {
+    swap_write (slot, pages[0]);
+    return;
+  }
+
+  lock_acquire (&cluster_lock);
+  for (; cnt > 0; slot += n, pages += n, cnt -= n) {
+    n = cnt < SWAP_CLUSTER ? cnt : SWAP_CLUSTER;
+    for (i = 0; i < n; i++) {
+      memcpy (cluster_buffer + i * PGSIZE, pages[i], PGSIZE);
+    }
+    block_write_multiple (swap_device, slot * PAGE_SECTORS,
+                          n * PAGE_SECTORS, cluster_buffer);
+  }
+  lock_release (&cluster_lock);
+}
+
+/* Reads the CNT consecutive swap-slots starting at SLOT into the
+   CNT pages in PAGES, in a single request for each SWAP_CLUSTER
+   of them, leaving the slots reserved */
+void
+swap_read_cluster (size_t slot, size_t cnt, void *const pages[])
+{
+  size_t i, n;
+
+  if (cnt == 1) {
+    swap_read (slot, pages[0]);
+    return;
+  }
+
+  lock_acquire (&cluster_lock);
+  for (; cnt > 0; slot += n, pages += n, cnt -= n) {
+    n = cnt < SWAP_CLUSTER ? cnt : SWAP_CLUSTER;
+    block_read_multiple (swap_device, slot * PAGE_SECTORS,
+                         n * PAGE_SECTORS, cluster_buffer);
+    for (i = 0; i < n; i++) {
+      memcpy (pages[i], cluster_buffer + i * PGSIZE, PGSIZE);
+    }
+  }
+  lock_release (&cluster_lock);
+}
+
 /* Clears the swap-slot SLOT so that it can be used for another page */
 void
 swap_drop (size_t slot)
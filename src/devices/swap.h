@@ -3,9 +3,19 @@
 
 #include <stddef.h>
 
+/* Maximum number of pages evicted to consecutive swap-slots in
+   one batch, and read back in together on a fault. */
+#define SWAP_CLUSTER 8
+
 void swap_init (void);
 size_t swap_out (const void *vaddr);
 void swap_in (void *vaddr, size_t slot);
 void swap_drop (size_t slot);
 
+size_t swap_alloc (size_t cnt);
+void swap_write (size_t slot, const void *vaddr);
+void swap_read (size_t slot, void *vaddr);
+void swap_write_cluster (size_t slot, size_t cnt, void *const pages[]);
+void swap_read_cluster (size_t slot, size_t cnt, void *const pages[]);
+
 #endif /* devices/swap.h */
@@ -17,8 +17,11 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-/* Number of timer ticks since OS booted. */
+/* Number of timer ticks since OS booted.  Advanced under
+   ticks_seqlock, so that timer_ticks() can read all 64 bits of
+   it consistently without turning interrupts off. */
 static int64_t ticks;
+static struct seqlock ticks_seqlock;
 
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
@@ -28,17 +31,70 @@ static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void advance_ticks (int64_t cnt);
 static void real_time_delay (int64_t num, int32_t denom);
 
-/* List storing sleeping threads */
-static struct list sleep_list;
+/* Sleeping threads are kept in a hierarchical timing wheel.
+   Level L has 2^timer_wheel_bits slots, each covering
+   2^(timer_wheel_bits * L) ticks.  A thread due within one
+   level's span of ticks sits in the level-0 slot for its exact
+   wake-up tick; one due later sits in a coarser slot and is
+   cascaded down a level each time the level below wraps around.
+   Threads due beyond the top level wait on wheel_overflow.
+   Arming a sleeper and expiring one are both O(1), amortized
+   over the at most WHEEL_LEVELS cascades a sleeper goes
+   through. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+
+/* Bits of the wake-up time resolved by each wheel level, at most
+   WHEEL_BITS.  Controlled by kernel command-line option
+   "-wheel=BITS", which lets tests reach every level of the wheel
+   within a few seconds. */
+unsigned timer_wheel_bits = WHEEL_BITS;
+#define WHEEL_MASK ((1 << timer_wheel_bits) - 1)
+
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static struct list wheel_overflow;
+
+/* Last tick processed by the wheel. */
+static int64_t wheel_time;
+
+/* -tickless: stop the periodic tick while the CPU is idle.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* PIT cycles in one timer tick. */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* While the idle thread has the periodic tick stopped, the
+   number of ticks until the one-shot interrupt it programmed,
+   and the PIT count that interrupt was programmed with.
+   STOPPED_TICKS is 0 while the tick is running. */
+static int stopped_ticks;
+static uint16_t stopped_count;
+
+static void restart_tick (int skipped);
+
+static void wheel_insert (struct thread *);
+static void wheel_advance (void);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
 void
 timer_init (void) 
 {
-  list_init(&sleep_list); /* initialise sleep list for sleeping threads*/
+  int level, slot;
+
+  if (timer_wheel_bits < 1 || timer_wheel_bits > WHEEL_BITS)
+    PANIC ("-wheel=BITS must be between 1 and %d", WHEEL_BITS);
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SIZE; slot++)
+      list_init (&wheel[level][slot]);
+  list_init (&wheel_overflow);
+  seqlock_init (&ticks_seqlock);
+
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -74,9 +130,15 @@ timer_calibrate (void)
 int64_t
 timer_ticks (void) 
 {
-  enum intr_level old_level = intr_disable ();
-  int64_t t = ticks;
-  intr_set_level (old_level);
+  unsigned seq;
+  int64_t t;
+
+  do
+    {
+      seq = seqlock_read_begin (&ticks_seqlock);
+      t = ticks;
+    }
+  while (seqlock_read_retry (&ticks_seqlock, seq));
   return t;
 }
 
@@ -88,45 +150,30 @@ timer_elapsed (int64_t then)
   return timer_ticks () - then;
 }
 
-/* function to compare new sleeping threads for inserting into sleep_list in the right order */
-static bool 
-order_threads(const struct list_elem *first, const struct list_elem *second, void *aux UNUSED) {
-  struct sleep_list_elem *thread_a = list_entry(first, struct sleep_list_elem, elem);
-  struct sleep_list_elem *thread_b = list_entry(second, struct sleep_list_elem, elem);
-  return thread_a->wake_up_time < thread_b->wake_up_time;
-}
-
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void
 timer_sleep (int64_t ticks) 
 {
-  if(ticks <= 0)
-    return;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
-  int64_t start = timer_ticks (); /* timer ticks in OS uptil timer_sleep was called */
-  ASSERT (intr_get_level () == INTR_ON); /* checks if interrupts are on */
-
-  /* create and initialize a semaphore for new sleeping thread*/
-  struct semaphore new_sema;
-  sema_init(&new_sema, 0);
-
-  /* initialise new 'sleeping' element to put on the sleep list */
-  struct sleep_list_elem new_sleep_thread;
-  new_sleep_thread.wake_up_time = start + ticks;
-  new_sleep_thread.thread_sema = &new_sema;
-
-  /* disable interrupts while accessing sleep_list which can be modified by timer_interrupt */
-  enum intr_level prev_level = intr_disable ();
+  if (ticks <= 0)
+    return;
 
-  /* insert new sleeping element to the sleep list (in order using specific comparing function) */
-  list_insert_ordered(&sleep_list, &(new_sleep_thread.elem), &order_threads, NULL);
+  ASSERT (intr_get_level () == INTR_ON);
 
-  /* down the semaphore (essentialy blocking the thread) */
-  sema_down(&new_sema);
+  cur->wake_up_time = timer_ticks () + ticks;
 
-  /* enable interrupts*/
-  intr_set_level (prev_level);
+  /* The wheel is advanced by timer_interrupt, so it must not
+     move while this thread is being added to it. */
+  old_level = intr_disable ();
+  if (cur->wake_up_time > wheel_time)
+    {
+      wheel_insert (cur);
+      thread_block ();
+    }
+  intr_set_level (old_level);
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -203,22 +250,196 @@ timer_print_stats (void)
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
-  ticks++;
-
-  /* traverse the sleep_list and check if any threads need to wake up */
-  while(!list_empty(&sleep_list)){
-    struct sleep_list_elem *sleep_thread = list_entry(list_begin(&sleep_list), struct sleep_list_elem, elem);
-
-    if(timer_ticks () >= sleep_thread->wake_up_time){
-      /* if thread is ready to wake up -> release semaphore and pop from the sleep list */
-      sema_up(sleep_thread->thread_sema);
-      list_pop_front(&sleep_list);
-    } else {
-      break;
+  /* The one-shot interrupt programmed by timer_idle_enter() is
+     due on the last of the ticks it stood in for. */
+  if (stopped_ticks > 0)
+    restart_tick (stopped_ticks - 1);
+
+  advance_ticks (1);
+  wheel_advance ();
+  thread_tick ();
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  If no sleeper, wheel cascade, scheduler
+   update or real-time budget release is due for at least the
+   next two ticks, replaces the
+   periodic tick by a single interrupt on the first tick at
+   which one is due, as far ahead as the 16-bit PIT count
+   allows. */
+void
+timer_idle_enter (void)
+{
+  uint16_t remaining;
+  int64_t release;
+  int n, max_ticks;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || stopped_ticks > 0)
+    return;
+
+  /* The current tick is REMAINING cycles from its end; the
+     one-shot count has to cover that plus N - 1 whole ticks. */
+  remaining = pit_read_count (0, NULL);
+  if (remaining == 0 || remaining > TICK_CYCLES)
+    return;
+  max_ticks = (UINT16_MAX - remaining) / TICK_CYCLES + 1;
+  release = thread_edf_next_release ();
+
+  for (n = 1; n < max_ticks; n++)
+    {
+      int64_t t = ticks + n;
+      if (!list_empty (&wheel[0][t & WHEEL_MASK])
+          || (t & WHEEL_MASK) == 0
+          || (thread_mlfqs && t % TIMER_FREQ == 0)
+          || t >= release)
+        break;
+    }
+  if (n < 2)
+    return;
+
+  stopped_ticks = n;
+  stopped_count = remaining + (n - 1) * TICK_CYCLES;
+  pit_start_oneshot (0, stopped_count);
+}
+
+/* Called by the idle thread, with interrupts off, once the CPU
+   wakes up from its halt.  If the tick is still stopped, some
+   other interrupt woke the CPU before the one-shot interrupt
+   did, so catches TICKS up to the ticks that have passed and
+   moves the one-shot interrupt in to the end of the current
+   tick, which then restarts the periodic tick in step with the
+   old one. */
+void
+timer_idle_exit (void)
+{
+  uint16_t count;
+  int elapsed, first, skipped;
+  bool fired;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (stopped_ticks == 0)
+    return;
+
+  /* If the count has run out, the one-shot interrupt is pending
+     and timer_interrupt() catches up as soon as interrupts are
+     enabled. */
+  count = pit_read_count (0, &fired);
+  if (fired)
+    return;
+
+  /* The first skipped tick ended FIRST cycles into the count,
+     and each later one TICK_CYCLES after that. */
+  elapsed = stopped_count - count;
+  first = stopped_count - (stopped_ticks - 1) * TICK_CYCLES;
+  skipped = elapsed < first ? 0 : (elapsed - first) / TICK_CYCLES + 1;
+  if (skipped >= stopped_ticks)
+    return;
+
+  advance_ticks (skipped);
+  wheel_time = ticks;
+  thread_skip_ticks (skipped);
+
+  /* Reprogramming in mode 0 keeps the output low, so this does
+     not raise a spurious interrupt the way switching straight
+     back to mode 2 would. */
+  stopped_ticks = 1;
+  stopped_count = first + skipped * TICK_CYCLES - elapsed;
+  pit_start_oneshot (0, stopped_count);
+}
+
+/* Accounts for SKIPPED ticks that passed while the periodic tick
+   was stopped and restarts it.  timer_idle_enter() made sure
+   that nothing was due on any of those ticks, so the wheel can
+   jump over them.  Called from the one-shot timer interrupt,
+   when the PIT output is already high, so switching back to
+   mode 2 raises no further interrupt. */
+static void
+restart_tick (int skipped)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  pit_configure_channel (0, 2, TIMER_FREQ);
+  stopped_ticks = 0;
+
+  advance_ticks (skipped);
+  wheel_time = ticks;
+  thread_skip_ticks (skipped);
+}
+
+/* Adds sleeping thread T to the timing wheel slot that will
+   come due at T->wake_up_time.  Interrupts must be off. */
+static void
+wheel_insert (struct thread *t)
+{
+  int64_t delta = t->wake_up_time - wheel_time;
+  int level;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (delta >= 0);
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    if (delta < (int64_t) 1 << (timer_wheel_bits * (level + 1)))
+      {
+        int slot = (t->wake_up_time >> (timer_wheel_bits * level)) & WHEEL_MASK;
+        list_push_back (&wheel[level][slot], &t->elem);
+        return;
+      }
+  list_push_back (&wheel_overflow, &t->elem);
+}
+
+/* Re-inserts every thread in LIST relative to the current
+   wheel_time, which moves each one down at least one level. */
+static void
+wheel_cascade (struct list *list)
+{
+  struct list pending;
+
+  list_init (&pending);
+  while (!list_empty (list))
+    list_push_back (&pending, list_pop_front (list));
+  while (!list_empty (&pending))
+    wheel_insert (list_entry (list_pop_front (&pending), struct thread, elem));
+}
+
+/* Adds CNT to the tick count. */
+static void
+advance_ticks (int64_t cnt)
+{
+  seqlock_write_begin (&ticks_seqlock);
+  ticks += cnt;
+  seqlock_write_end (&ticks_seqlock);
+}
+
+/* Moves the wheel forward to the current tick and wakes every
+   thread whose wake-up time has arrived. */
+static void
+wheel_advance (void)
+{
+  struct list *due;
+  int level;
+
+  wheel_time = ticks;
+
+  /* When a level wraps around, the next slot of the level above
+     becomes due within that level's range: spread it out. */
+  for (level = 1; level <= WHEEL_LEVELS; level++)
+    {
+      int64_t below = wheel_time >> (timer_wheel_bits * (level - 1));
+      if ((below & WHEEL_MASK) != 0)
+        break;
+      if (level == WHEEL_LEVELS)
+        wheel_cascade (&wheel_overflow);
+      else
+        wheel_cascade (&wheel[level][(below >> timer_wheel_bits)
+                                     & WHEEL_MASK]);
     }
-  }
-  thread_tick();
 
+  due = &wheel[0][wheel_time & WHEEL_MASK];
+  while (!list_empty (due))
+    thread_unblock (list_entry (list_pop_front (due), struct thread, elem));
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -4,15 +4,6 @@
 #include <round.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include "lib/kernel/list.h"
-
-/* structure for element of the sleeping threads list */
-struct sleep_list_elem {
-  struct semaphore *thread_sema; /* to unblock a sleeping thread */
-
-  int64_t wake_up_time;      /* Stores wake up time for sleeping thread. */
-  struct list_elem elem;     /* List element to store sema of sleeping thread in sleep list*/
-};
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
@@ -36,4 +27,12 @@ void timer_ndelay (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Timing wheel geometry. */
+extern unsigned timer_wheel_bits;
+
+/* Tickless idle. */
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 #endif /* devices/timer.h */
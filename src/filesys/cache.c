@@ -0,0 +1,254 @@
+#include "filesys/cache.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of sectors the cache holds. */
+#define CACHE_SIZE 64
+
+/* Timer ticks between runs of the flusher. */
+#define FLUSH_TICKS TIMER_FREQ
+
+/* Maximum number of read-ahead requests waiting. */
+#define READAHEAD_MAX 16
+
+/* A cached sector. */
+struct cache_entry
+  {
+    block_sector_t sector;              /* Sector held. */
+    bool in_use;                        /* Does it hold a sector? */
+    bool loading;                       /* Being read from disk? */
+    bool dirty;                         /* Changed since read? */
+    bool accessed;                      /* Used since the clock passed? */
+    uint8_t data[BLOCK_SECTOR_SIZE];    /* Sector contents. */
+  };
+
+/* The cache.  Everything in it, and the read-ahead queue, is
+   protected by cache_lock.  The lock is released while a sector
+   is read into an entry, which is marked loading meanwhile;
+   cache_loaded is signaled when a read finishes. */
+static struct cache_entry *cache;
+static struct lock cache_lock;
+static struct condition cache_loaded;
+static size_t clock_hand;               /* Next entry the clock checks. */
+
+/* Sectors waiting for the read-ahead thread, a ring buffer. */
+static block_sector_t readahead_queue[READAHEAD_MAX];
+static size_t readahead_head;           /* Oldest request. */
+static size_t readahead_cnt;            /* Number of requests. */
+static struct condition readahead_wanted;
+
+static thread_func flush_daemon NO_RETURN;
+static thread_func readahead_daemon NO_RETURN;
+static struct cache_entry *cache_lookup (block_sector_t);
+static struct cache_entry *cache_get (block_sector_t, bool read);
+static struct cache_entry *cache_evict (void);
+
+/* Initializes the buffer cache and starts its flusher and
+   read-ahead threads. */
+void
+cache_init (void)
+{
+  cache = calloc (CACHE_SIZE, sizeof *cache);
+  if (cache == NULL)
+    PANIC ("Not enough memory for buffer cache.");
+  lock_init (&cache_lock);
+  cond_init (&cache_loaded);
+  cond_init (&readahead_wanted);
+  clock_hand = 0;
+
+  thread_create ("flush", PRI_DEFAULT, flush_daemon, NULL);
+  thread_create ("readahead", PRI_DEFAULT, readahead_daemon, NULL);
+}
+
+/* Reads SIZE bytes starting at byte OFS within SECTOR into
+   BUFFER. */
+void
+cache_read (block_sector_t sector, void *buffer, int ofs, int size)
+{
+  struct cache_entry *e;
+
+  ASSERT (ofs >= 0 && size >= 0 && ofs + size <= BLOCK_SECTOR_SIZE);
+
+  lock_acquire (&cache_lock);
+  e = cache_get (sector, true);
+  memcpy (buffer, e->data + ofs, size);
+  lock_release (&cache_lock);
+}
+
+/* Writes SIZE bytes from BUFFER starting at byte OFS within
+   SECTOR.  The sector is only read from disk first if the write
+   does not cover all of it. */
+void
+cache_write (block_sector_t sector, const void *buffer, int ofs, int size)
+{
+  struct cache_entry *e;
+
+  ASSERT (ofs >= 0 && size >= 0 && ofs + size <= BLOCK_SECTOR_SIZE);
+
+  lock_acquire (&cache_lock);
+  e = cache_get (sector, size < BLOCK_SECTOR_SIZE);
+  memcpy (e->data + ofs, buffer, size);
+  e->dirty = true;
+  lock_release (&cache_lock);
+}
+
+/* Asks for SECTOR to be read into the cache in the background,
+   because it will probably be read soon.  The request is dropped
+   if the sector is already cached or too many are waiting. */
+void
+cache_readahead (block_sector_t sector)
+{
+  lock_acquire (&cache_lock);
+  if (readahead_cnt < READAHEAD_MAX && cache_lookup (sector) == NULL)
+    {
+      readahead_queue[(readahead_head + readahead_cnt++) % READAHEAD_MAX]
+        = sector;
+      cond_signal (&readahead_wanted, &cache_lock);
+    }
+  lock_release (&cache_lock);
+}
+
+/* Writes every dirty sector in the cache to disk. */
+void
+cache_flush (void)
+{
+  size_t i;
+
+  for (i = 0; i < CACHE_SIZE; i++)
+    {
+      struct cache_entry *e = &cache[i];
+
+      lock_acquire (&cache_lock);
+      if (e->in_use && e->dirty && !e->loading)
+        {
+          block_write (fs_device, e->sector, e->data);
+          e->dirty = false;
+        }
+      lock_release (&cache_lock);
+    }
+}
+
+/* Writes dirty sectors back to disk every FLUSH_TICKS, so that
+   they do not wait for eviction. */
+static void
+flush_daemon (void *aux UNUSED)
+{
+  for (;;)
+    {
+      timer_sleep (FLUSH_TICKS);
+      cache_flush ();
+    }
+}
+
+/* Reads the sectors asked for by cache_readahead(). */
+static void
+readahead_daemon (void *aux UNUSED)
+{
+  lock_acquire (&cache_lock);
+  for (;;)
+    {
+      block_sector_t sector;
+
+      while (readahead_cnt == 0)
+        cond_wait (&readahead_wanted, &cache_lock);
+      sector = readahead_queue[readahead_head];
+      readahead_head = (readahead_head + 1) % READAHEAD_MAX;
+      readahead_cnt--;
+
+      cache_get (sector, true);
+    }
+}
+
+/* Returns the entry that holds SECTOR, or a null pointer if
+   there is none.  Must be called with cache_lock held. */
+static struct cache_entry *
+cache_lookup (block_sector_t sector)
+{
+  size_t i;
+
+  for (i = 0; i < CACHE_SIZE; i++)
+    if (cache[i].in_use && cache[i].sector == sector)
+      return &cache[i];
+  return NULL;
+}
+
+/* Returns the entry that holds SECTOR, evicting another sector
+   to make room for it if necessary.  A newly cached sector is
+   read from disk if READ is true; otherwise the caller must
+   overwrite all of it.  Must be called with cache_lock held,
+   which is released while the sector is read. */
+static struct cache_entry *
+cache_get (block_sector_t sector, bool read)
+{
+  struct cache_entry *e;
+
+  for (;;)
+    {
+      e = cache_lookup (sector);
+      if (e == NULL || !e->loading)
+        break;
+      cond_wait (&cache_loaded, &cache_lock);
+    }
+  if (e != NULL)
+    {
+      e->accessed = true;
+      return e;
+    }
+
+  e = cache_evict ();
+  e->sector = sector;
+  e->in_use = true;
+  e->dirty = false;
+  e->accessed = true;
+  if (read)
+    {
+      e->loading = true;
+      lock_release (&cache_lock);
+      block_read (fs_device, sector, e->data);
+      lock_acquire (&cache_lock);
+      e->loading = false;
+      cond_broadcast (&cache_loaded, &cache_lock);
+    }
+  return e;
+}
+
+/* Chooses an entry to reuse with the clock algorithm, writes
+   its sector back if it is dirty, and returns it.  Waits if
+   every entry is being read.  Must be called with cache_lock
+   held. */
+static struct cache_entry *
+cache_evict (void)
+{
+  for (;;)
+    {
+      size_t i;
+
+      for (i = 0; i < 2 * CACHE_SIZE; i++)
+        {
+          struct cache_entry *e = &cache[clock_hand];
+          clock_hand = (clock_hand + 1) % CACHE_SIZE;
+
+          if (!e->in_use)
+            return e;
+          if (e->loading)
+            continue;
+          if (e->accessed)
+            {
+              e->accessed = false;
+              continue;
+            }
+
+          if (e->dirty)
+            block_write (fs_device, e->sector, e->data);
+          e->in_use = false;
+          return e;
+        }
+      cond_wait (&cache_loaded, &cache_lock);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef FILESYS_CACHE_H
+#define FILESYS_CACHE_H
+
+#include "devices/block.h"
+
+/* Buffer cache.
+
+   Keeps recently used sectors of the file system device in
+   memory.  Writes only reach the disk when a dirty sector is
+   evicted, when the periodic flusher runs, or on
+   cache_flush(). */
+
+void cache_init (void);
+void cache_read (block_sector_t, void *buffer, int ofs, int size);
+void cache_write (block_sector_t, const void *buffer, int ofs, int size);
+void cache_readahead (block_sector_t);
+void cache_flush (void);
+
+#endif /* filesys/cache.h */
@@ -1,6 +1,7 @@
 #include "filesys/directory.h"
 #include <stdio.h>
 #include <string.h>
+#include <hash.h>
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
@@ -21,12 +22,64 @@ struct dir_entry
     bool in_use;                        /* In use or free? */
   };
 
-/* Creates a directory with space for ENTRY_CNT entries in the
-   given SECTOR.  Returns true if successful, false on failure. */
+/* A directory is a hash table of its entries, stored as a file
+   of BLOCK_SECTOR_SIZE blocks.  Block 0 is the header, which
+   holds the head of one chain of buckets per hash value.  Every
+   other block is a bucket of entries, linked into exactly one
+   chain.  New buckets are appended to the file and pushed on the
+   front of their chain, so looking up a name only reads the few
+   buckets of its chain, and the bucket with room for a new entry
+   is usually the first one looked at. */
+
+/* Number of hash chains. */
+#define DIR_CHAINS (BLOCK_SECTOR_SIZE / sizeof (uint32_t))
+
+/* Number of entries in a bucket. */
+#define BUCKET_ENTRIES \
+        ((BLOCK_SECTOR_SIZE - sizeof (uint32_t)) / sizeof (struct dir_entry))
+
+/* Directory header, in block 0.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct dir_header
+  {
+    uint32_t chains[DIR_CHAINS];        /* First bucket block, or 0. */
+  };
+
+/* Bucket of entries.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct dir_bucket
+  {
+    uint32_t next;                      /* Next bucket block, or 0. */
+    struct dir_entry entries[BUCKET_ENTRIES];
+    uint8_t unused[BLOCK_SECTOR_SIZE - sizeof (uint32_t)
+                   - BUCKET_ENTRIES * sizeof (struct dir_entry)];
+  };
+
+/* Returns the hash chain that NAME belongs in. */
+static size_t
+chain_of (const char *name)
+{
+  return hash_string (name) % DIR_CHAINS;
+}
+
+/* Returns the byte offset of entry IDX in bucket block BLOCK. */
+static off_t
+entry_ofs (uint32_t block, size_t idx)
+{
+  return (block * BLOCK_SECTOR_SIZE + offsetof (struct dir_bucket, entries)
+          + idx * sizeof (struct dir_entry));
+}
+
+/* Creates an empty directory in the given SECTOR.  Directories
+   grow as files are added, so ENTRY_CNT is ignored.
+   Returns true if successful, false on failure. */
 bool
-dir_create (block_sector_t sector, size_t entry_cnt)
+dir_create (block_sector_t sector, size_t entry_cnt UNUSED)
 {
-  return inode_create (sector, entry_cnt * sizeof (struct dir_entry));
+  ASSERT (sizeof (struct dir_header) == BLOCK_SECTOR_SIZE);
+  ASSERT (sizeof (struct dir_bucket) == BLOCK_SECTOR_SIZE);
+
+  return inode_create (sector, sizeof (struct dir_header));
 }
 
 /* Opens and returns the directory for the given INODE, of which
@@ -87,28 +140,87 @@ dir_get_inode (struct dir *dir)
    If successful, returns true, sets *EP to the directory entry
    if EP is non-null, and sets *OFSP to the byte offset of the
    directory entry if OFSP is non-null.
-   otherwise, returns false and ignores EP and OFSP. */
+   otherwise, returns false and ignores EP and OFSP.
+   Either way, if FREEP is non-null, sets *FREEP to the byte
+   offset of a free entry in NAME's chain, or to 0 if the chain
+   has none. */
 static bool
 lookup (const struct dir *dir, const char *name,
-        struct dir_entry *ep, off_t *ofsp) 
+        struct dir_entry *ep, off_t *ofsp, off_t *freep) 
 {
-  struct dir_entry e;
-  size_t ofs;
-  
+  struct dir_bucket *bucket;
+  uint32_t block;
+  bool found = false;
+
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (e.in_use && !strcmp (name, e.name)) 
-      {
-        if (ep != NULL)
-          *ep = e;
-        if (ofsp != NULL)
-          *ofsp = ofs;
-        return true;
-      }
-  return false;
+  if (freep != NULL)
+    *freep = 0;
+
+  if (inode_read_at (dir->inode, &block, sizeof block,
+                     chain_of (name) * sizeof block) != sizeof block)
+    return false;
+
+  bucket = malloc (sizeof *bucket);
+  if (bucket == NULL)
+    return false;
+
+  for (; block != 0 && !found; block = bucket->next)
+    {
+      size_t i;
+
+      if (inode_read_at (dir->inode, bucket, sizeof *bucket,
+                         block * BLOCK_SECTOR_SIZE) != sizeof *bucket)
+        break;
+      for (i = 0; i < BUCKET_ENTRIES; i++)
+        {
+          struct dir_entry *e = &bucket->entries[i];
+
+          if (!e->in_use)
+            {
+              if (freep != NULL && *freep == 0)
+                *freep = entry_ofs (block, i);
+            }
+          else if (!strcmp (name, e->name))
+            {
+              if (ep != NULL)
+                *ep = *e;
+              if (ofsp != NULL)
+                *ofsp = entry_ofs (block, i);
+              found = true;
+              break;
+            }
+        }
+    }
+  free (bucket);
+  return found;
+}
+
+/* Appends an empty bucket to DIR, puts it at the front of CHAIN,
+   and returns the byte offset of its first entry, or 0 if the
+   disk or memory is full. */
+static off_t
+add_bucket (struct dir *dir, size_t chain)
+{
+  struct dir_bucket *bucket;
+  uint32_t block;
+  off_t ofs = 0;
+
+  bucket = calloc (1, sizeof *bucket);
+  if (bucket == NULL)
+    return 0;
+
+  block = inode_length (dir->inode) / BLOCK_SECTOR_SIZE;
+  if (inode_read_at (dir->inode, &bucket->next, sizeof bucket->next,
+                     chain * sizeof block) == sizeof bucket->next
+      && inode_write_at (dir->inode, bucket, sizeof *bucket,
+                         block * BLOCK_SECTOR_SIZE) == sizeof *bucket
+      && inode_write_at (dir->inode, &block, sizeof block,
+                         chain * sizeof block) == sizeof block)
+    ofs = entry_ofs (block, 0);
+  free (bucket);
+  return ofs;
 }
 
 /* Searches DIR for a file with the given NAME
@@ -124,7 +236,7 @@ dir_lookup (const struct dir *dir, const char *name,
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
-  if (lookup (dir, name, &e, NULL))
+  if (lookup (dir, name, &e, NULL, NULL))
     *inode = inode_open (e.inode_sector);
   else
     *inode = NULL;
@@ -152,21 +264,17 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   if (*name == '\0' || strlen (name) > NAME_MAX)
     return false;
 
-  /* Check that NAME is not in use. */
-  if (lookup (dir, name, NULL, NULL))
+  /* Check that NAME is not in use, and set OFS to the offset of
+     a free slot in its chain.  If the chain is full, give it a
+     new bucket. */
+  if (lookup (dir, name, NULL, NULL, &ofs))
     goto done;
-
-  /* Set OFS to offset of free slot.
-     If there are no free slots, then it will be set to the
-     current end-of-file.
-     
-     inode_read_at() will only return a short read at end of file.
-     Otherwise, we'd need to verify that we didn't get a short
-     read due to something intermittent such as low memory. */
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (!e.in_use)
-      break;
+  if (ofs == 0)
+    {
+      ofs = add_bucket (dir, chain_of (name));
+      if (ofs == 0)
+        goto done;
+    }
 
   /* Write slot. */
   e.in_use = true;
@@ -193,7 +301,7 @@ dir_remove (struct dir *dir, const char *name)
   ASSERT (name != NULL);
 
   /* Find directory entry. */
-  if (!lookup (dir, name, &e, &ofs))
+  if (!lookup (dir, name, &e, &ofs, NULL))
     goto done;
 
   /* Open inode. */
@@ -217,15 +325,22 @@ dir_remove (struct dir *dir, const char *name)
 
 /* Reads the next directory entry in DIR and stores the name in
    NAME.  Returns true if successful, false if the directory
-   contains no more entries. */
+   contains no more entries.  Entries are returned in the order
+   they are stored, bucket by bucket, not by name. */
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
 {
   struct dir_entry e;
 
-  while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) 
+  /* DIR->POS counts entries from the start of the first bucket. */
+  for (;;)
     {
-      dir->pos += sizeof e;
+      uint32_t block = dir->pos / BUCKET_ENTRIES + 1;
+      off_t ofs = entry_ofs (block, dir->pos % BUCKET_ENTRIES);
+
+      if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+        break;
+      dir->pos++;
       if (e.in_use)
         {
           strlcpy (name, e.name, NAME_MAX + 1);
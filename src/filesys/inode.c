@@ -1,8 +1,10 @@
 #include "filesys/inode.h"
+#include <hash.h>
 #include <list.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
@@ -10,16 +12,57 @@
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Number of closed inodes kept in memory in case they are opened
+   again. */
+#define CLOSED_MAX 16
+
+/* Number of data sectors an inode points to directly. */
+#define DIRECT_CNT 124
+
+/* Number of sector numbers in an indirect block. */
+#define INDIRECT_CNT (BLOCK_SECTOR_SIZE / sizeof (block_sector_t))
+
+/* Maximum number of data sectors in a file. */
+#define MAX_SECTORS (DIRECT_CNT + INDIRECT_CNT + INDIRECT_CNT * INDIRECT_CNT)
+
+/* Largest file whose data is kept in its inode. */
+#define INLINE_MAX ((DIRECT_CNT + 2) * sizeof (block_sector_t))
+
 /* On-disk inode.
-   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+   Must be exactly BLOCK_SECTOR_SIZE bytes long.
+
+   A file of at most INLINE_MAX bytes keeps its data in the inode
+   itself, in place of the sector numbers, so that reading it
+   takes no sector beyond the inode's.  It moves to data sectors
+   once it grows past that.
+
+   Otherwise, the first DIRECT_CNT data sectors are listed in the
+   inode, the next INDIRECT_CNT in the indirect block, and the
+   rest in the blocks the doubly indirect block lists.  Sector 0,
+   which holds the free map's inode, means none. */
 struct inode_disk
   {
-    block_sector_t start;               /* First data sector. */
     off_t length;                       /* File size in bytes. */
     unsigned magic;                     /* Magic number. */
-    uint32_t unused[125];               /* Not used. */
+    union
+      {
+        uint8_t data[INLINE_MAX];       /* Data of a small file. */
+        struct
+          {
+            block_sector_t direct[DIRECT_CNT]; /* Direct data sectors. */
+            block_sector_t indirect;    /* Indirect block. */
+            block_sector_t doubly_indirect; /* Doubly indirect block. */
+          };
+      };
   };
 
+/* Returns true if DISK_INODE's data is kept inline. */
+static inline bool
+is_inline (const struct inode_disk *disk_inode)
+{
+  return disk_inode->length <= (off_t) INLINE_MAX;
+}
+
 /* Returns the number of sectors to allocate for an inode SIZE
    bytes long. */
 static inline size_t
@@ -28,14 +71,116 @@ bytes_to_sectors (off_t size)
   return DIV_ROUND_UP (size, BLOCK_SECTOR_SIZE);
 }
 
+static bool inode_grow (struct inode_disk *, off_t length);
+static bool inode_uninline (struct inode_disk *, off_t length);
+static void inode_release_sectors (struct inode_disk *, size_t from,
+                                   size_t to);
+
+/* Returns entry IDX of indirect block BLOCK. */
+static block_sector_t
+index_get (block_sector_t block, size_t idx)
+{
+  block_sector_t sector;
+  cache_read (block, &sector, idx * sizeof sector, sizeof sector);
+  return sector;
+}
+
+/* Sets entry IDX of indirect block BLOCK to SECTOR. */
+static void
+index_set (block_sector_t block, size_t idx, block_sector_t sector)
+{
+  cache_write (block, &sector, idx * sizeof sector, sizeof sector);
+}
+
+/* Makes *BLOCK an indirect block, allocating one full of zeros
+   near sector NEAR if it is 0.  Returns false if the disk is
+   full. */
+static bool
+index_alloc (block_sector_t *block, block_sector_t near)
+{
+  static char zeros[BLOCK_SECTOR_SIZE];
+
+  if (*block != 0)
+    return true;
+  if (!free_map_allocate_near (near, 1, block))
+    return false;
+  cache_write (*block, zeros, 0, BLOCK_SECTOR_SIZE);
+  return true;
+}
+
+/* Returns data sector IDX of DISK_INODE, or 0 if it has none. */
+static block_sector_t
+data_sector (const struct inode_disk *disk_inode, size_t idx)
+{
+  block_sector_t block;
+
+  ASSERT (idx < MAX_SECTORS);
+
+  if (idx < DIRECT_CNT)
+    return disk_inode->direct[idx];
+  idx -= DIRECT_CNT;
+
+  if (idx < INDIRECT_CNT)
+    return (disk_inode->indirect != 0
+            ? index_get (disk_inode->indirect, idx) : 0);
+  idx -= INDIRECT_CNT;
+
+  if (disk_inode->doubly_indirect == 0)
+    return 0;
+  block = index_get (disk_inode->doubly_indirect, idx / INDIRECT_CNT);
+  return block != 0 ? index_get (block, idx % INDIRECT_CNT) : 0;
+}
+
+/* Makes SECTOR data sector IDX of DISK_INODE, allocating the
+   indirect blocks needed to point to it.  Returns false if the
+   disk is full. */
+static bool
+set_data_sector (struct inode_disk *disk_inode, size_t idx,
+                 block_sector_t sector)
+{
+  block_sector_t block;
+
+  ASSERT (idx < MAX_SECTORS);
+
+  if (idx < DIRECT_CNT)
+    {
+      disk_inode->direct[idx] = sector;
+      return true;
+    }
+  idx -= DIRECT_CNT;
+
+  if (idx < INDIRECT_CNT)
+    {
+      if (!index_alloc (&disk_inode->indirect, sector))
+        return false;
+      index_set (disk_inode->indirect, idx, sector);
+      return true;
+    }
+  idx -= INDIRECT_CNT;
+
+  if (!index_alloc (&disk_inode->doubly_indirect, sector))
+    return false;
+  block = index_get (disk_inode->doubly_indirect, idx / INDIRECT_CNT);
+  if (block == 0)
+    {
+      if (!index_alloc (&block, sector))
+        return false;
+      index_set (disk_inode->doubly_indirect, idx / INDIRECT_CNT, block);
+    }
+  index_set (block, idx % INDIRECT_CNT, sector);
+  return true;
+}
+
 /* In-memory inode. */
 struct inode 
   {
-    struct list_elem elem;              /* Element in inode list. */
+    struct hash_elem hash_elem;         /* Element in inode table. */
+    struct list_elem lru_elem;          /* Element in closed list. */
     block_sector_t sector;              /* Sector number of disk location. */
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    off_t next_read;                    /* Where a sequential read resumes. */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -48,20 +193,31 @@ byte_to_sector (const struct inode *inode, off_t pos)
 {
   ASSERT (inode != NULL);
   if (pos < inode->data.length)
-    return inode->data.start + pos / BLOCK_SECTOR_SIZE;
+    return data_sector (&inode->data, pos / BLOCK_SECTOR_SIZE);
   else
     return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
-   returns the same `struct inode'. */
-static struct list open_inodes;
+/* Inodes in memory, by sector, so that opening a single inode
+   twice returns the same `struct inode'.  Besides the open inodes,
+   the table keeps up to CLOSED_MAX inodes that have been closed
+   and not removed, so that opening one of them again does not
+   re-read it.  Those are also in closed_inodes, most recently
+   closed first. */
+static struct hash inode_table;
+static struct list closed_inodes;
+static size_t closed_cnt;
+
+static hash_hash_func inode_hash;
+static hash_less_func inode_less;
 
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
-  list_init (&open_inodes);
+  hash_init (&inode_table, inode_hash, inode_less, NULL);
+  list_init (&closed_inodes);
+  closed_cnt = 0;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -84,20 +240,11 @@ inode_create (block_sector_t sector, off_t length)
   disk_inode = calloc (1, sizeof *disk_inode);
   if (disk_inode != NULL)
     {
-      size_t sectors = bytes_to_sectors (length);
-      disk_inode->length = length;
       disk_inode->magic = INODE_MAGIC;
-      if (free_map_allocate (sectors, &disk_inode->start)) 
+      if (length <= (off_t) INLINE_MAX || inode_grow (disk_inode, length)) 
         {
-          block_write (fs_device, sector, disk_inode);
-          if (sectors > 0) 
-            {
-              static char zeros[BLOCK_SECTOR_SIZE];
-              size_t i;
-              
-              for (i = 0; i < sectors; i++) 
-                block_write (fs_device, disk_inode->start + i, zeros);
-            }
+          disk_inode->length = length;
+          cache_write (sector, disk_inode, 0, BLOCK_SECTOR_SIZE);
           success = true; 
         } 
       free (disk_inode);
@@ -111,19 +258,23 @@ inode_create (block_sector_t sector, off_t length)
 struct inode *
 inode_open (block_sector_t sector)
 {
-  struct list_elem *e;
+  struct inode temp;
+  struct hash_elem *e;
   struct inode *inode;
 
-  /* Check whether this inode is already open. */
-  for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-       e = list_next (e)) 
+  /* Check whether this inode is already in memory. */
+  temp.sector = sector;
+  e = hash_find (&inode_table, &temp.hash_elem);
+  if (e != NULL)
     {
-      inode = list_entry (e, struct inode, elem);
-      if (inode->sector == sector) 
+      inode = hash_entry (e, struct inode, hash_elem);
+      if (inode->open_cnt == 0)
         {
-          inode_reopen (inode);
-          return inode; 
+          list_remove (&inode->lru_elem);
+          closed_cnt--;
+          inode->next_read = 0;
         }
+      return inode_reopen (inode);
     }
 
   /* Allocate memory. */
@@ -132,12 +283,13 @@ inode_open (block_sector_t sector)
     return NULL;
 
   /* Initialize. */
-  list_push_front (&open_inodes, &inode->elem);
   inode->sector = sector;
+  hash_insert (&inode_table, &inode->hash_elem);
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
-  block_read (fs_device, inode->sector, &inode->data);
+  inode->next_read = 0;
+  cache_read (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
   return inode;
 }
 
@@ -158,8 +310,11 @@ inode_get_inumber (const struct inode *inode)
 }
 
 /* Closes INODE and writes it to disk.
-   If this was the last reference to INODE, frees its memory.
-   If INODE was also a removed inode, frees its blocks. */
+   If this was the last reference to INODE, keeps it among the
+   recently closed inodes, freeing the memory of the least
+   recently closed one if there are too many.
+   If INODE was also a removed inode, frees its memory and its
+   blocks. */
 void
 inode_close (struct inode *inode) 
 {
@@ -170,21 +325,49 @@ inode_close (struct inode *inode)
   /* Release resources if this was the last opener. */
   if (--inode->open_cnt == 0)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
- 
       /* Deallocate blocks if removed. */
       if (inode->removed) 
         {
+          hash_delete (&inode_table, &inode->hash_elem);
           free_map_release (inode->sector, 1);
-          free_map_release (inode->data.start,
-                            bytes_to_sectors (inode->data.length)); 
+          if (!is_inline (&inode->data))
+            inode_release_sectors (&inode->data, 0,
+                                   bytes_to_sectors (inode->data.length));
+          free (inode);
+          return;
         }
 
-      free (inode); 
+      list_push_front (&closed_inodes, &inode->lru_elem);
+      if (++closed_cnt > CLOSED_MAX)
+        {
+          struct inode *old = list_entry (list_pop_back (&closed_inodes),
+                                          struct inode, lru_elem);
+          hash_delete (&inode_table, &old->hash_elem);
+          closed_cnt--;
+          free (old);
+        }
     }
 }
 
+/* Hashes an inode by its sector. */
+static unsigned
+inode_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct inode *inode = hash_entry (e, struct inode, hash_elem);
+  return hash_int (inode->sector);
+}
+
+/* Orders inodes by sector. */
+static bool
+inode_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct inode *a = hash_entry (a_, struct inode, hash_elem);
+  const struct inode *b = hash_entry (b_, struct inode, hash_elem);
+
+  return a->sector < b->sector;
+}
+
 /* Marks INODE to be deleted when it is closed by the last caller who
    has it open. */
 void
@@ -202,7 +385,18 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
 {
   uint8_t *buffer = buffer_;
   off_t bytes_read = 0;
-  uint8_t *bounce = NULL;
+  bool sequential = offset == inode->next_read;
+
+  if (is_inline (&inode->data))
+    {
+      /* Copy straight out of the inode. */
+      off_t inode_left = inode_length (inode) - offset;
+      bytes_read = size < inode_left ? size : inode_left;
+      if (bytes_read <= 0)
+        return 0;
+      memcpy (buffer, inode->data.data + offset, bytes_read);
+      return bytes_read;
+    }
 
   while (size > 0) 
     {
@@ -220,51 +414,65 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
-        {
-          /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
-        }
-      else 
-        {
-          /* Read sector into bounce buffer, then partially copy
-             into caller's buffer. */
-          if (bounce == NULL) 
-            {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
-              if (bounce == NULL)
-                break;
-            }
-          block_read (fs_device, sector_idx, bounce);
-          memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-        }
+      cache_read (sector_idx, buffer + bytes_read, sector_ofs, chunk_size);
       
       /* Advance. */
       size -= chunk_size;
       offset += chunk_size;
       bytes_read += chunk_size;
     }
-  free (bounce);
+
+  /* A read that picks up where the last one stopped is probably
+     part of a sequential scan: fetch the next sector before it
+     is asked for. */
+  inode->next_read = offset;
+  if (sequential && bytes_read > 0)
+    {
+      off_t next = ROUND_UP (offset, BLOCK_SECTOR_SIZE);
+      if (next < inode_length (inode))
+        cache_readahead (byte_to_sector (inode, next));
+    }
 
   return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
    Returns the number of bytes actually written, which may be
-   less than SIZE if end of file is reached or an error occurs.
-   (Normally a write at end of file would extend the inode, but
-   growth is not yet implemented.) */
+   less than SIZE if an error occurs.  A write past end of file
+   extends the inode, filling any gap with zeros; if the disk is
+   full, nothing is written. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
                 off_t offset) 
 {
   const uint8_t *buffer = buffer_;
   off_t bytes_written = 0;
-  uint8_t *bounce = NULL;
 
-  if (inode->deny_write_cnt)
+  if (inode->deny_write_cnt || size <= 0)
     return 0;
 
+  if (offset + size > inode_length (inode))
+    {
+      /* Extend the file, moving its data out of the inode if it
+         no longer fits there. */
+      if (offset + size > (off_t) INLINE_MAX
+          && !(is_inline (&inode->data)
+               ? inode_uninline (&inode->data, offset + size)
+               : inode_grow (&inode->data, offset + size)))
+        return 0;
+      inode->data.length = offset + size;
+      if (!is_inline (&inode->data))
+        cache_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+    }
+
+  if (is_inline (&inode->data))
+    {
+      /* Write straight into the inode. */
+      memcpy (inode->data.data + offset, buffer, size);
+      cache_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+      return size;
+    }
+
   while (size > 0) 
     {
       /* Sector to write, starting byte offset within sector. */
@@ -281,38 +489,13 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
-        {
-          /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
-        }
-      else 
-        {
-          /* We need a bounce buffer. */
-          if (bounce == NULL) 
-            {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
-              if (bounce == NULL)
-                break;
-            }
-
-          /* If the sector contains data before or after the chunk
-             we're writing, then we need to read in the sector
-             first.  Otherwise we start with a sector of all zeros. */
-          if (sector_ofs > 0 || chunk_size < sector_left) 
-            block_read (fs_device, sector_idx, bounce);
-          else
-            memset (bounce, 0, BLOCK_SECTOR_SIZE);
-          memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-          block_write (fs_device, sector_idx, bounce);
-        }
+      cache_write (sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
 
       /* Advance. */
       size -= chunk_size;
       offset += chunk_size;
       bytes_written += chunk_size;
     }
-  free (bounce);
 
   return bytes_written;
 }
@@ -343,3 +526,125 @@ inode_length (const struct inode *inode)
 {
   return inode->data.length;
 }
+
+/* Gives DISK_INODE enough zeroed data sectors for LENGTH bytes,
+   but does not change its length.  New sectors come from the run
+   of free sectors right after the file's last sector if there is
+   one, or else from the first run free, so that files stay
+   contiguous as they grow.  Returns false, having allocated
+   nothing, if the disk is full. */
+static bool
+inode_grow (struct inode_disk *disk_inode, off_t length)
+{
+  static char zeros[BLOCK_SECTOR_SIZE];
+  size_t have = bytes_to_sectors (disk_inode->length);
+  size_t want = bytes_to_sectors (length);
+  size_t idx = have;
+  block_sector_t near = have > 0 ? data_sector (disk_inode, have - 1) + 1 : 0;
+
+  if (want > MAX_SECTORS)
+    return false;
+
+  while (idx < want)
+    {
+      block_sector_t start;
+      size_t run = want - idx;
+      size_t i;
+
+      /* Take all the sectors still needed as one run if possible,
+         otherwise one at a time. */
+      if (!free_map_allocate_near (near, run, &start))
+        {
+          run = 1;
+          if (!free_map_allocate_near (near, 1, &start))
+            goto fail;
+        }
+
+      for (i = 0; i < run; i++, idx++)
+        {
+          if (!set_data_sector (disk_inode, idx, start + i))
+            {
+              free_map_release (start + i, run - i);
+              goto fail;
+            }
+          cache_write (start + i, zeros, 0, BLOCK_SECTOR_SIZE);
+        }
+      near = start + run;
+    }
+  return true;
+
+ fail:
+  inode_release_sectors (disk_inode, have, idx);
+  return false;
+}
+
+/* Moves the data of DISK_INODE, which is kept inline, to data
+   sectors, giving it enough of them for LENGTH bytes, which must
+   be more than INLINE_MAX.  The caller must then set the length,
+   which this leaves alone.  Returns false, leaving DISK_INODE as
+   it was, if memory or disk space runs out. */
+static bool
+inode_uninline (struct inode_disk *disk_inode, off_t length)
+{
+  off_t old_length = disk_inode->length;
+  uint8_t *data = malloc (INLINE_MAX);
+
+  if (data == NULL)
+    return false;
+  memcpy (data, disk_inode->data, INLINE_MAX);
+
+  memset (disk_inode->data, 0, INLINE_MAX);
+  disk_inode->length = 0;
+  if (!inode_grow (disk_inode, length))
+    {
+      memcpy (disk_inode->data, data, INLINE_MAX);
+      disk_inode->length = old_length;
+      free (data);
+      return false;
+    }
+  disk_inode->length = old_length;
+
+  if (old_length > 0)
+    cache_write (disk_inode->direct[0], data, 0, old_length);
+  free (data);
+  return true;
+}
+
+/* Releases data sectors FROM up to but not including TO of
+   DISK_INODE, along with the indirect blocks that only point to
+   sectors from FROM on. */
+static void
+inode_release_sectors (struct inode_disk *disk_inode, size_t from,
+                       size_t to)
+{
+  size_t idx;
+
+  for (idx = from; idx < to; idx++)
+    free_map_release (data_sector (disk_inode, idx), 1);
+
+  if (disk_inode->doubly_indirect != 0)
+    {
+      size_t first = DIRECT_CNT + INDIRECT_CNT;
+      size_t i;
+
+      for (i = 0; first + i * INDIRECT_CNT < to; i++)
+        {
+          block_sector_t block = index_get (disk_inode->doubly_indirect, i);
+          if (first + i * INDIRECT_CNT >= from && block != 0)
+            {
+              free_map_release (block, 1);
+              index_set (disk_inode->doubly_indirect, i, 0);
+            }
+        }
+      if (from <= first)
+        {
+          free_map_release (disk_inode->doubly_indirect, 1);
+          disk_inode->doubly_indirect = 0;
+        }
+    }
+  if (from <= DIRECT_CNT && disk_inode->indirect != 0)
+    {
+      free_map_release (disk_inode->indirect, 1);
+      disk_inode->indirect = 0;
+    }
+}
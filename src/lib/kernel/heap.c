@@ -0,0 +1,217 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* Pairing heap.
+
+   Every element is no greater than any of its children.  The
+   children of an element form a doubly linked list through their
+   `next' and `prev' members, except that the leftmost child's
+   `prev' points to the parent instead; the root has no siblings
+   and a null `prev'.
+
+   Two heaps are melded by making the root with the greater key
+   the leftmost child of the other.  Popping the root melds its
+   children pairwise from left to right, then melds the pairs
+   together from right to left.  See Fredman et al., "The pairing
+   heap: a new form of self-adjusting heap", Algorithmica 1
+   (1986). */
+
+static bool elem_less (const struct heap *, const struct heap_elem *,
+                       const struct heap_elem *);
+static struct heap_elem *meld (const struct heap *, struct heap_elem *,
+                               struct heap_elem *);
+static struct heap_elem *merge_pairs (const struct heap *,
+                                      struct heap_elem *first);
+static void detach (struct heap_elem *);
+
+/* Initializes HEAP as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux)
+{
+  ASSERT (heap != NULL);
+  ASSERT (less != NULL);
+
+  heap->root = NULL;
+  heap->elem_cnt = 0;
+  heap->next_seq = 0;
+  heap->less = less;
+  heap->aux = aux;
+}
+
+/* Inserts E into HEAP, after any elements equal to it. */
+void
+heap_push (struct heap *heap, struct heap_elem *e)
+{
+  ASSERT (e != NULL);
+
+  e->child = e->next = e->prev = NULL;
+  e->seq = heap->next_seq++;
+  heap->root = heap->root != NULL ? meld (heap, heap->root, e) : e;
+  heap->elem_cnt++;
+}
+
+/* Removes and returns the least element of HEAP, which must not
+   be empty. */
+struct heap_elem *
+heap_pop (struct heap *heap)
+{
+  struct heap_elem *top = heap->root;
+
+  ASSERT (top != NULL);
+
+  heap->root = merge_pairs (heap, top->child);
+  heap->elem_cnt--;
+  top->child = NULL;
+  return top;
+}
+
+/* Removes E from HEAP, which must contain it. */
+void
+heap_remove (struct heap *heap, struct heap_elem *e)
+{
+  struct heap_elem *sub;
+
+  ASSERT (e != NULL);
+
+  if (e == heap->root)
+    {
+      heap_pop (heap);
+      return;
+    }
+
+  detach (e);
+  sub = merge_pairs (heap, e->child);
+  e->child = NULL;
+  if (sub != NULL)
+    heap->root = meld (heap, heap->root, sub);
+  heap->elem_cnt--;
+}
+
+/* Restores the heap order of HEAP after the key of E, which HEAP
+   contains, was changed to compare less than before.  E keeps its
+   place among elements equal to it.  To change a key the other
+   way, remove the element and push it again. */
+void
+heap_promote (struct heap *heap, struct heap_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e == heap->root)
+    return;
+
+  /* E's subtree is still heap-ordered, so it can move as a
+     whole. */
+  detach (e);
+  heap->root = meld (heap, heap->root, e);
+}
+
+/* Returns the least element of HEAP, or a null pointer if HEAP is
+   empty. */
+struct heap_elem *
+heap_top (const struct heap *heap)
+{
+  return heap->root;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (const struct heap *heap)
+{
+  return heap->elem_cnt;
+}
+
+/* Returns true if HEAP contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *heap)
+{
+  return heap->root == NULL;
+}
+
+/* Returns true if A belongs above B in HEAP: if A is less than B,
+   or equal to B and pushed earlier. */
+static bool
+elem_less (const struct heap *heap, const struct heap_elem *a,
+           const struct heap_elem *b)
+{
+  if (heap->less (a, b, heap->aux))
+    return true;
+  if (heap->less (b, a, heap->aux))
+    return false;
+  return (int) (a->seq - b->seq) < 0;
+}
+
+/* Melds the heaps rooted at A and B, neither of which has
+   siblings, and returns the root of the result. */
+static struct heap_elem *
+meld (const struct heap *heap, struct heap_elem *a, struct heap_elem *b)
+{
+  if (elem_less (heap, b, a))
+    {
+      struct heap_elem *t = a;
+      a = b;
+      b = t;
+    }
+
+  /* Make B the leftmost child of A. */
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+  a->next = a->prev = NULL;
+  return a;
+}
+
+/* Melds the list of siblings that starts at FIRST into one heap,
+   in two passes, and returns its root, or a null pointer if the
+   list is empty. */
+static struct heap_elem *
+merge_pairs (const struct heap *heap, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root = NULL;
+
+  /* Meld pairs from left to right, collecting the results in
+     reverse order through their `next' members. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+
+      if (b != NULL)
+        {
+          first = b->next;
+          a = meld (heap, a, b);
+        }
+      else
+        first = NULL;
+      a->next = pairs;
+      pairs = a;
+    }
+
+  /* Meld the pairs together from right to left. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *next = pairs->next;
+
+      pairs->next = pairs->prev = NULL;
+      root = root != NULL ? meld (heap, root, pairs) : pairs;
+      pairs = next;
+    }
+  return root;
+}
+
+/* Unlinks E, which is not a root, and its subtree from its parent
+   and siblings. */
+static void
+detach (struct heap_elem *e)
+{
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  e->next = e->prev = NULL;
+}
@@ -0,0 +1,350 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Red-black tree.
+
+   Every element is either red or black, and the tree maintains
+   two invariants that together bound its height by 2 lg(n+1):
+
+     1. A red element has no red children.
+
+     2. Every path from an element down to a null leaf passes
+        through the same number of black elements.
+
+   The root is always black.  See [CLRS] chapter 13 for the
+   algorithms below; the deletion code tracks the parent of the
+   node being fixed up explicitly because null leaves have no
+   parent pointer of their own. */
+
+static void rotate_left (struct rb_tree *, struct rb_elem *);
+static void rotate_right (struct rb_tree *, struct rb_elem *);
+static void replace_child (struct rb_tree *, struct rb_elem *parent,
+                           struct rb_elem *old, struct rb_elem *new);
+static void insert_fixup (struct rb_tree *, struct rb_elem *);
+static void remove_fixup (struct rb_tree *, struct rb_elem *,
+                          struct rb_elem *parent);
+
+static inline bool
+is_red (const struct rb_elem *e)
+{
+  return e != NULL && e->red;
+}
+
+/* Initializes TREE as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *tree, rb_less_func *less, void *aux)
+{
+  ASSERT (tree != NULL);
+  ASSERT (less != NULL);
+
+  tree->root = NULL;
+  tree->min = NULL;
+  tree->elem_cnt = 0;
+  tree->less = less;
+  tree->aux = aux;
+}
+
+/* Inserts NEW into TREE, after any elements equal to it. */
+void
+rb_insert (struct rb_tree *tree, struct rb_elem *new)
+{
+  struct rb_elem *parent = NULL;
+  struct rb_elem **link = &tree->root;
+  bool leftmost = true;
+
+  ASSERT (new != NULL);
+
+  while (*link != NULL)
+    {
+      parent = *link;
+      if (tree->less (new, parent, tree->aux))
+        link = &parent->left;
+      else
+        {
+          link = &parent->right;
+          leftmost = false;
+        }
+    }
+
+  new->parent = parent;
+  new->left = new->right = NULL;
+  new->red = true;
+  *link = new;
+  if (leftmost)
+    tree->min = new;
+  tree->elem_cnt++;
+
+  insert_fixup (tree, new);
+}
+
+/* Removes E from TREE, which must contain it. */
+void
+rb_remove (struct rb_tree *tree, struct rb_elem *e)
+{
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT (e != NULL);
+  ASSERT (tree->elem_cnt > 0);
+
+  if (tree->min == e)
+    tree->min = rb_next (e);
+
+  if (e->left == NULL || e->right == NULL)
+    {
+      /* E has at most one child, which takes its place. */
+      child = e->left != NULL ? e->left : e->right;
+      parent = e->parent;
+      removed_red = e->red;
+      if (child != NULL)
+        child->parent = parent;
+      replace_child (tree, parent, e, child);
+    }
+  else
+    {
+      /* E has two children.  Its successor S, the leftmost
+         element of its right subtree, has no left child.  Unlink
+         S from its position and move it into E's. */
+      struct rb_elem *s = e->right;
+      while (s->left != NULL)
+        s = s->left;
+
+      child = s->right;
+      removed_red = s->red;
+      if (s->parent == e)
+        parent = s;
+      else
+        {
+          parent = s->parent;
+          parent->left = child;
+          if (child != NULL)
+            child->parent = parent;
+          s->right = e->right;
+          s->right->parent = s;
+        }
+      s->left = e->left;
+      s->left->parent = s;
+      s->parent = e->parent;
+      s->red = e->red;
+      replace_child (tree, e->parent, e, s);
+    }
+
+  tree->elem_cnt--;
+  if (!removed_red)
+    remove_fixup (tree, child, parent);
+}
+
+/* Returns the least element in TREE, or a null pointer if TREE
+   is empty. */
+struct rb_elem *
+rb_min (const struct rb_tree *tree)
+{
+  return tree->min;
+}
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the greatest element. */
+struct rb_elem *
+rb_next (const struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->right != NULL)
+    {
+      e = e->right;
+      while (e->left != NULL)
+        e = e->left;
+      return (struct rb_elem *) e;
+    }
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+rb_size (const struct rb_tree *tree)
+{
+  return tree->elem_cnt;
+}
+
+/* Returns true if TREE contains no elements, false otherwise. */
+bool
+rb_empty (const struct rb_tree *tree)
+{
+  return tree->elem_cnt == 0;
+}
+
+/* Makes NEW take OLD's place as a child of PARENT, or as the
+   root of TREE if PARENT is null. */
+static void
+replace_child (struct rb_tree *tree, struct rb_elem *parent,
+               struct rb_elem *old, struct rb_elem *new)
+{
+  if (parent == NULL)
+    tree->root = new;
+  else if (parent->left == old)
+    parent->left = new;
+  else
+    parent->right = new;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's
+   right child takes its place and X becomes its left child. */
+static void
+rotate_left (struct rb_tree *tree, struct rb_elem *x)
+{
+  struct rb_elem *y = x->right;
+
+  x->right = y->left;
+  if (y->left != NULL)
+    y->left->parent = x;
+  y->parent = x->parent;
+  replace_child (tree, x->parent, x, y);
+  y->left = x;
+  x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's
+   left child takes its place and X becomes its right child. */
+static void
+rotate_right (struct rb_tree *tree, struct rb_elem *x)
+{
+  struct rb_elem *y = x->left;
+
+  x->left = y->right;
+  if (y->right != NULL)
+    y->right->parent = x;
+  y->parent = x->parent;
+  replace_child (tree, x->parent, x, y);
+  y->right = x;
+  x->parent = y;
+}
+
+/* Restores the red-black invariants after red element E was
+   linked into TREE as a leaf. */
+static void
+insert_fixup (struct rb_tree *tree, struct rb_elem *e)
+{
+  while (is_red (e->parent))
+    {
+      struct rb_elem *parent = e->parent;
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left)
+        {
+          struct rb_elem *uncle = grandparent->right;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->right)
+            {
+              rotate_left (tree, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_right (tree, grandparent);
+        }
+      else
+        {
+          struct rb_elem *uncle = grandparent->left;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->left)
+            {
+              rotate_right (tree, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_left (tree, grandparent);
+        }
+    }
+  tree->root->red = false;
+}
+
+/* Restores the red-black invariants after a black element was
+   unlinked from TREE.  E, which may be null, is the element that
+   took its place, and PARENT is E's parent. */
+static void
+remove_fixup (struct rb_tree *tree, struct rb_elem *e,
+              struct rb_elem *parent)
+{
+  while (e != tree->root && !is_red (e))
+    {
+      if (e == parent->left)
+        {
+          struct rb_elem *sibling = parent->right;
+          if (is_red (sibling))
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_left (tree, parent);
+              sibling = parent->right;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+              continue;
+            }
+          if (!is_red (sibling->right))
+            {
+              sibling->left->red = false;
+              sibling->red = true;
+              rotate_right (tree, sibling);
+              sibling = parent->right;
+            }
+          sibling->red = parent->red;
+          parent->red = false;
+          sibling->right->red = false;
+          rotate_left (tree, parent);
+        }
+      else
+        {
+          struct rb_elem *sibling = parent->left;
+          if (is_red (sibling))
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_right (tree, parent);
+              sibling = parent->left;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+              continue;
+            }
+          if (!is_red (sibling->left))
+            {
+              sibling->right->red = false;
+              sibling->red = true;
+              rotate_left (tree, sibling);
+              sibling = parent->left;
+            }
+          sibling->red = parent->red;
+          parent->red = false;
+          sibling->left->red = false;
+          rotate_right (tree, parent);
+        }
+      e = tree->root;
+    }
+  if (e != NULL)
+    e->red = false;
+}
@@ -0,0 +1,132 @@
+/* Creates 1,000 threads, each of which sleeps 5 times for a
+   different duration of up to 300 ticks, so that the timer has
+   many sleepers spread over several levels of its wheel at once.
+   Verifies that no thread ever wakes up early, and reports how
+   late wake-ups were and how long the run took beyond the
+   longest sleep schedule, as a measure of the cost of arming and
+   expiring that many timers. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/devices/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 1000
+#define ITERATIONS 5
+#define MAX_DURATION 300
+
+/* Information about the test. */
+struct sleep_test 
+  {
+    int64_t start;              /* Current time at start of test. */
+    struct semaphore done;      /* Upped by each sleeper when it finishes. */
+
+    /* Output, protected by output_lock. */
+    struct lock output_lock;    /* Lock protecting the results. */
+    int early_cnt;              /* Number of early wake-ups. */
+    int64_t max_lateness;       /* Latest wake-up, in ticks past due. */
+    int64_t last_due;           /* Latest wake-up time of any thread. */
+  };
+
+/* Information about an individual thread in the test. */
+struct sleep_thread 
+  {
+    struct sleep_test *test;    /* Info shared between all threads. */
+    int id;                     /* Sleeper ID. */
+  };
+
+static void sleeper (void *);
+static int duration (int id, int iteration);
+
+void
+test_alarm_stress (void) 
+{
+  struct sleep_test test;
+  struct sleep_thread *threads;
+  int64_t elapsed;
+  int i;
+
+  msg ("Creating %d threads to sleep %d times each.", THREAD_CNT, ITERATIONS);
+  msg ("Each sleep lasts between 1 and %d ticks.", MAX_DURATION);
+
+  threads = malloc (sizeof *threads * THREAD_CNT);
+  if (threads == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  /* Initialize test. */
+  test.start = timer_ticks () + 100;
+  sema_init (&test.done, 0);
+  lock_init (&test.output_lock);
+  test.early_cnt = 0;
+  test.max_lateness = 0;
+  test.last_due = test.start;
+
+  /* Start threads. */
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct sleep_thread *t = threads + i;
+      char name[16];
+
+      t->test = &test;
+      t->id = i;
+
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, t) == TID_ERROR)
+        fail ("creating thread %d failed", i);
+    }
+
+  /* Wait for all the threads to finish. */
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&test.done);
+  elapsed = timer_elapsed (test.last_due);
+
+  if (test.early_cnt > 0)
+    fail ("%d wake-ups happened before they were due", test.early_cnt);
+  msg ("All threads woke up on or after their wake-up time.");
+  msg ("Latest wake-up: %"PRId64" ticks after it was due.", test.max_lateness);
+  msg ("Run finished %"PRId64" ticks after the last wake-up was due.",
+       elapsed);
+
+  free (threads);
+}
+
+/* Returns the length of sleeper ID's ITERATION'th sleep. */
+static int
+duration (int id, int iteration)
+{
+  return 1 + (id * 37 + iteration * 101) % MAX_DURATION;
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *t_) 
+{
+  struct sleep_thread *t = t_;
+  struct sleep_test *test = t->test;
+  int64_t sleep_until = test->start;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int64_t lateness;
+
+      sleep_until += duration (t->id, i);
+      timer_sleep (sleep_until - timer_ticks ());
+      lateness = timer_ticks () - sleep_until;
+
+      lock_acquire (&test->output_lock);
+      if (lateness < 0)
+        test->early_cnt++;
+      else if (lateness > test->max_lateness)
+        test->max_lateness = lateness;
+      if (sleep_until > test->last_due)
+        test->last_due = sleep_until;
+      lock_release (&test->output_lock);
+    }
+
+  sema_up (&test->done);
+}
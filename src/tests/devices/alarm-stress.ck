@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# The timing figures depend on the host, so only their presence
+# is checked.
+my (@expected) = (
+    qr/^\(alarm-stress\) begin$/,
+    qr/^\(alarm-stress\) Creating 1000 threads to sleep 5 times each\.$/,
+    qr/^\(alarm-stress\) Each sleep lasts between 1 and 300 ticks\.$/,
+    qr/^\(alarm-stress\) All threads woke up on or after their wake-up time\.$/,
+    qr/^\(alarm-stress\) Latest wake-up: \d+ ticks after it was due\.$/,
+    qr/^\(alarm-stress\) Run finished \d+ ticks after the last wake-up was due\.$/,
+    qr/^\(alarm-stress\) end$/);
+
+fail "Expected " . scalar (@expected) . " lines of output but got "
+  . scalar (@output) . "\n"
+  if @output != @expected;
+for my $i (0...$#expected) {
+    fail "Unexpected output line: $output[$i]\n"
+      if $output[$i] !~ $expected[$i];
+}
+pass;
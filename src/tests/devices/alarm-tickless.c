@@ -0,0 +1,60 @@
+/* Runs with the -tickless option, so that the idle thread stops
+   the periodic timer tick while the test sleeps.  Checks that
+   sleeps of various lengths still end on exactly the tick they
+   were due, and that timer_ticks() keeps pace with the real-time
+   clock across a longer sleep. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/devices/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/rtc.h"
+#include "devices/timer.h"
+
+/* Sleep lengths, chosen to cover single ticks, runs shorter and
+   longer than the PIT's one-shot range, and wheel cascades. */
+static const int durations[] = {1, 2, 3, 4, 5, 7, 11, 50, 64, 130};
+
+/* Length of the real-time check, in seconds. */
+#define RTC_SECONDS 5
+
+void
+test_alarm_tickless (void) 
+{
+  int64_t wake_time;
+  time_t rtc_start, rtc_end;
+  size_t i;
+
+  if (!timer_tickless)
+    fail ("test must be run with -tickless");
+
+  msg ("Sleeping %zu times for between 1 and 130 ticks.",
+       sizeof durations / sizeof *durations);
+  wake_time = timer_ticks ();
+  for (i = 0; i < sizeof durations / sizeof *durations; i++)
+    {
+      int64_t now;
+
+      wake_time += durations[i];
+      timer_sleep (wake_time - timer_ticks ());
+      now = timer_ticks ();
+      if (now != wake_time)
+        fail ("sleep of %d ticks ended on tick %"PRId64", expected %"PRId64,
+              durations[i], now, wake_time);
+    }
+  msg ("All sleeps ended on the tick they were due.");
+
+  /* Line up with the start of a real-time clock second. */
+  rtc_start = rtc_get_time ();
+  while (rtc_get_time () == rtc_start)
+    timer_sleep (1);
+  rtc_start = rtc_get_time ();
+
+  timer_sleep (RTC_SECONDS * TIMER_FREQ);
+  rtc_end = rtc_get_time ();
+  if (rtc_end - rtc_start < RTC_SECONDS - 1 || rtc_end - rtc_start > RTC_SECONDS + 1)
+    fail ("%d seconds of ticks took %lu seconds of real time",
+          RTC_SECONDS, rtc_end - rtc_start);
+  msg ("%d seconds of ticks matched the real-time clock.", RTC_SECONDS);
+}
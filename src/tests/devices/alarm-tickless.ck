@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-tickless) begin
+(alarm-tickless) Sleeping 10 times for between 1 and 130 ticks.
+(alarm-tickless) All sleeps ended on the tick they were due.
+(alarm-tickless) 5 seconds of ticks matched the real-time clock.
+(alarm-tickless) end
+EOF
+pass;
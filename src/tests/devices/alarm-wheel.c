@@ -0,0 +1,106 @@
+/* Runs with the -wheel=2 option, which shrinks each level of the
+   timer's timing wheel to 4 slots, so that the level boundaries
+   fall at 4, 16 and 64 ticks and sleeps of 256 ticks or more go
+   to the overflow list.  Starts sleepers whose durations fall
+   just below, on and just above each boundary, all at the same
+   tick, and checks that each one wakes up on exactly the tick it
+   was due, in order of duration, after being cascaded down
+   through the levels. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/devices/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Sleep lengths, in increasing order. */
+static const int durations[] =
+  {3, 4, 5, 15, 16, 17, 63, 64, 65, 255, 256, 257, 700};
+#define SLEEPER_CNT (sizeof durations / sizeof *durations)
+
+/* Information about the test. */
+struct sleep_test 
+  {
+    int64_t start;              /* Tick at which all sleeps start. */
+    struct semaphore done;      /* Upped by each sleeper when it finishes. */
+    size_t woken_cnt;           /* Number of sleepers woken so far. */
+    size_t order[SLEEPER_CNT];  /* Sleepers, in the order they woke. */
+    int64_t woke[SLEEPER_CNT];  /* Tick each sleeper woke up on. */
+  };
+
+/* Information about an individual sleeper. */
+struct sleep_thread 
+  {
+    struct sleep_test *test;    /* Info shared between all threads. */
+    size_t id;                  /* Index in durations[]. */
+  };
+
+static void sleeper (void *);
+
+void
+test_alarm_wheel (void) 
+{
+  struct sleep_test test;
+  struct sleep_thread threads[SLEEPER_CNT];
+  size_t i;
+
+  if (timer_wheel_bits != 2)
+    fail ("test must be run with -wheel=2");
+
+  msg ("Starting %zu sleepers at the same tick.", SLEEPER_CNT);
+
+  /* Start a few ticks past a multiple of 256 ticks, so that the
+     sleeps end out of step with every level of the wheel. */
+  test.start = (timer_ticks () + 10 + 255) / 256 * 256 + 3;
+  sema_init (&test.done, 0);
+  test.woken_cnt = 0;
+
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      char name[16];
+
+      threads[i].test = &test;
+      threads[i].id = i;
+      snprintf (name, sizeof name, "sleeper %zu", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, &threads[i])
+          == TID_ERROR)
+        fail ("creating sleeper %zu failed", i);
+    }
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_down (&test.done);
+
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      size_t id = test.order[i];
+      int64_t late = test.woke[id] - (test.start + durations[id]);
+
+      if (late == 0)
+        msg ("Sleeper for %d ticks woke up on time.", durations[id]);
+      else
+        msg ("Sleeper for %d ticks woke up %"PRId64" ticks %s.",
+             durations[id], late < 0 ? -late : late,
+             late < 0 ? "early" : "late");
+    }
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *t_) 
+{
+  struct sleep_thread *t = t_;
+  struct sleep_test *test = t->test;
+  enum intr_level old_level;
+
+  timer_sleep (test->start - timer_ticks ());
+  timer_sleep (test->start + durations[t->id] - timer_ticks ());
+
+  old_level = intr_disable ();
+  test->woke[t->id] = timer_ticks ();
+  test->order[test->woken_cnt++] = t->id;
+  intr_set_level (old_level);
+
+  sema_up (&test->done);
+}
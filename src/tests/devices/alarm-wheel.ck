@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-wheel) begin
+(alarm-wheel) Starting 13 sleepers at the same tick.
+(alarm-wheel) Sleeper for 3 ticks woke up on time.
+(alarm-wheel) Sleeper for 4 ticks woke up on time.
+(alarm-wheel) Sleeper for 5 ticks woke up on time.
+(alarm-wheel) Sleeper for 15 ticks woke up on time.
+(alarm-wheel) Sleeper for 16 ticks woke up on time.
+(alarm-wheel) Sleeper for 17 ticks woke up on time.
+(alarm-wheel) Sleeper for 63 ticks woke up on time.
+(alarm-wheel) Sleeper for 64 ticks woke up on time.
+(alarm-wheel) Sleeper for 65 ticks woke up on time.
+(alarm-wheel) Sleeper for 255 ticks woke up on time.
+(alarm-wheel) Sleeper for 256 ticks woke up on time.
+(alarm-wheel) Sleeper for 257 ticks woke up on time.
+(alarm-wheel) Sleeper for 700 ticks woke up on time.
+(alarm-wheel) end
+EOF
+pass;
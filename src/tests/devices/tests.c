@@ -18,7 +18,10 @@ static const struct test tests[] =
     {"alarm-no-busy-wait", test_alarm_no_busy_wait},
     {"alarm-one",          test_alarm_one},
     {"alarm-zero",         test_alarm_zero},
-    {"alarm-negative",     test_alarm_negative}
+    {"alarm-negative",     test_alarm_negative},
+    {"alarm-stress",       test_alarm_stress},
+    {"alarm-tickless",     test_alarm_tickless},
+    {"alarm-wheel",        test_alarm_wheel}
   };
 #else
 static const struct test tests[] = 
@@ -30,6 +33,9 @@ static const struct test tests[] =
     {"alarm-one",          test_alarm_one},
     {"alarm-zero",         test_alarm_zero},
     {"alarm-negative",     test_alarm_negative},      
+    {"alarm-stress",       test_alarm_stress},
+    {"alarm-tickless",     test_alarm_tickless},
+    {"alarm-wheel",        test_alarm_wheel},
     {"alarm-priority", test_alarm_priority},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
@@ -44,6 +50,7 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"priority-rwlock", test_priority_rwlock},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -53,6 +60,18 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"cfs-fair-2", test_cfs_fair_2},
+    {"cfs-fair-20", test_cfs_fair_20},
+    {"cfs-nice-2", test_cfs_nice_2},
+    {"cfs-nice-10", test_cfs_nice_10},
+    {"edf-deadline", test_edf_deadline},
+    {"edf-budget", test_edf_budget},
+    {"edf-admission", test_edf_admission},
+    {"bench-switch", test_bench_switch},
+    {"bench-wakeup", test_bench_wakeup},
+    {"bench-donate", test_bench_donate},
+    {"bench-sleep", test_bench_sleep},
+    {"bench-waiters", test_bench_waiters},
   };  
 #endif
 
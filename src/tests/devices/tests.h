@@ -12,6 +12,9 @@ extern test_func test_alarm_no_busy_wait;
 extern test_func test_alarm_one;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_stress;
+extern test_func test_alarm_tickless;
+extern test_func test_alarm_wheel;
 
 #ifdef THREADS
 extern test_func test_alarm_priority;
@@ -28,6 +31,7 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_priority_rwlock;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -37,6 +41,18 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_cfs_fair_2;
+extern test_func test_cfs_fair_20;
+extern test_func test_cfs_nice_2;
+extern test_func test_cfs_nice_10;
+extern test_func test_edf_deadline;
+extern test_func test_edf_budget;
+extern test_func test_edf_admission;
+extern test_func test_bench_switch;
+extern test_func test_bench_wakeup;
+extern test_func test_bench_donate;
+extern test_func test_bench_sleep;
+extern test_func test_bench_waiters;
 #endif
 
 void msg (const char *, ...);
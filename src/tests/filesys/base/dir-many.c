@@ -0,0 +1,47 @@
+/* Creates 5,000 files in one directory, looks each of them up,
+   and removes them again.  Meant to show how directory lookup
+   scales with the number of entries: the kernel's "Timer: N
+   ticks" line at shutdown gives the time taken. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 5000
+
+void
+test_main (void) 
+{
+  char file_name[16];
+  int i;
+
+  msg ("create %d files", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (file_name, sizeof file_name, "file%d", i);
+      if (!create (file_name, 0))
+        fail ("create \"%s\"", file_name);
+    }
+
+  msg ("open each file");
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      int fd;
+
+      snprintf (file_name, sizeof file_name, "file%d", i);
+      fd = open (file_name);
+      if (fd < 2)
+        fail ("open \"%s\"", file_name);
+      close (fd);
+    }
+
+  msg ("remove each file");
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (file_name, sizeof file_name, "file%d", i);
+      if (!remove (file_name))
+        fail ("remove \"%s\"", file_name);
+    }
+  CHECK (open ("file0") == -1, "open \"file0\" after removal");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-many) begin
+(dir-many) create 5000 files
+(dir-many) open each file
+(dir-many) remove each file
+(dir-many) open "file0" after removal
+(dir-many) end
+EOF
+pass;
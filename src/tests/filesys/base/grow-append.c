@@ -0,0 +1,46 @@
+/* Creates an empty file and grows it by appending chunks of
+   varying size, past the sectors an inode reaches directly and
+   through its indirect block, so that the last part of the file
+   is indexed through the doubly indirect block.  Then closes the
+   file, reopens it, and verifies its contents. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* 124 direct and 128 indirect sectors hold 129,024 bytes. */
+#define FILE_SIZE 200000
+static char buf[FILE_SIZE];
+
+void
+test_main (void) 
+{
+  const char *file_name = "logfile";
+  size_t ofs = 0;
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+
+  random_init (0);
+  random_bytes (buf, sizeof buf);
+
+  msg ("append to \"%s\"", file_name);
+  while (ofs < FILE_SIZE) 
+    {
+      size_t size = 123 + ofs % 3001;
+      if (size > FILE_SIZE - ofs)
+        size = FILE_SIZE - ofs;
+      if (write (fd, buf + ofs, size) != (int) size)
+        fail ("write %zu bytes at offset %zu in \"%s\" failed",
+              size, ofs, file_name);
+      ofs += size;
+    }
+
+  CHECK (filesize (fd) == FILE_SIZE, "filesize \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+
+  check_file (file_name, buf, FILE_SIZE);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-append) begin
+(grow-append) create "logfile"
+(grow-append) open "logfile"
+(grow-append) append to "logfile"
+(grow-append) filesize "logfile"
+(grow-append) close "logfile"
+(grow-append) open "logfile" for verification
+(grow-append) verified contents of "logfile"
+(grow-append) close "logfile"
+(grow-append) end
+EOF
+pass;
@@ -0,0 +1,131 @@
+/* Test program for lib/kernel/heap.c.
+
+   Pushes elements in random order, changes and removes some of
+   them, and checks that the rest come off the heap in order,
+   with equal elements in the order they were pushed.
+
+   This is not a test we will run on your submitted tasks.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <heap.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Maximum number of elements in a heap that we will test. */
+#define MAX_SIZE 64
+
+/* A heap element. */
+struct value
+  {
+    struct heap_elem elem;      /* Heap element. */
+    int value;                  /* Item value. */
+    int seq;                    /* Order of insertion. */
+    bool removed;               /* Removed from the heap? */
+  };
+
+static void shuffle (struct value[], size_t);
+static bool value_less (const struct heap_elem *, const struct heap_elem *,
+                        void *);
+
+/* Test the heap implementation. */
+void
+test (void)
+{
+  int size;
+
+  printf ("testing various size heaps:");
+  for (size = 0; size < MAX_SIZE; size++)
+    {
+      int repeat;
+
+      printf (" %d", size);
+      for (repeat = 0; repeat < 10; repeat++)
+        {
+          static struct value values[MAX_SIZE];
+          struct heap heap;
+          const struct value *prev = NULL;
+          int i, cnt;
+
+          /* Push values with duplicates, in random order. */
+          for (i = 0; i < size; i++)
+            values[i].value = i / 2;
+          shuffle (values, size);
+          heap_init (&heap, value_less, NULL);
+          for (i = 0; i < size; i++)
+            {
+              values[i].seq = i;
+              values[i].removed = false;
+              heap_push (&heap, &values[i].elem);
+            }
+          ASSERT (heap_size (&heap) == (size_t) size);
+
+          /* Lower some keys, and remove some elements. */
+          cnt = size;
+          for (i = 0; i < size; i++)
+            switch (random_ulong () % 4)
+              {
+              case 0:
+                values[i].value -= random_ulong () % 8;
+                heap_promote (&heap, &values[i].elem);
+                break;
+              case 1:
+                values[i].removed = true;
+                heap_remove (&heap, &values[i].elem);
+                cnt--;
+                break;
+              }
+          ASSERT (heap_size (&heap) == (size_t) cnt);
+
+          /* Pop the rest and verify their order. */
+          for (i = 0; i < cnt; i++)
+            {
+              const struct value *v;
+
+              ASSERT (!heap_empty (&heap));
+              ASSERT (heap_top (&heap) != NULL);
+              v = heap_entry (heap_pop (&heap), struct value, elem);
+              ASSERT (!v->removed);
+              if (prev != NULL)
+                ASSERT (prev->value < v->value
+                        || (prev->value == v->value && prev->seq < v->seq));
+              prev = v;
+            }
+          ASSERT (heap_empty (&heap));
+          ASSERT (heap_top (&heap) == NULL);
+        }
+    }
+
+  printf (" done\n");
+  printf ("heap: PASS\n");
+}
+
+/* Shuffles the CNT elements in ARRAY into random order. */
+static void
+shuffle (struct value *array, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t j = i + random_ulong () % (cnt - i);
+      struct value t = array[j];
+      array[j] = array[i];
+      array[i] = t;
+    }
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+value_less (const struct heap_elem *a_, const struct heap_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = heap_entry (a_, struct value, elem);
+  const struct value *b = heap_entry (b_, struct value, elem);
+
+  return a->value < b->value;
+}
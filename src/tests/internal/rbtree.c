@@ -0,0 +1,176 @@
+/* Test program for lib/kernel/rbtree.c.
+
+   Inserts and removes elements in random order and checks the
+   ordering, the cached minimum, and the red-black invariants
+   after every operation.
+
+   This is not a test we will run on your submitted tasks.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <rbtree.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Maximum number of elements in a tree that we will test. */
+#define MAX_SIZE 64
+
+/* A tree element. */
+struct value
+  {
+    struct rb_elem elem;        /* Tree element. */
+    int value;                  /* Item value. */
+    int seq;                    /* Order of insertion. */
+  };
+
+static void shuffle (struct value[], size_t);
+static void shuffle_ints (int[], size_t);
+static bool value_less (const struct rb_elem *, const struct rb_elem *,
+                        void *);
+static int verify_subtree (const struct rb_elem *);
+static void verify_tree (struct rb_tree *, int size);
+
+/* Test the red-black tree implementation. */
+void
+test (void)
+{
+  int size;
+
+  printf ("testing various size trees:");
+  for (size = 0; size < MAX_SIZE; size++)
+    {
+      int repeat;
+
+      printf (" %d", size);
+      for (repeat = 0; repeat < 10; repeat++)
+        {
+          static struct value values[MAX_SIZE];
+          static int order[MAX_SIZE];
+          struct rb_tree tree;
+          int i;
+
+          /* Insert values with duplicates, in random order. */
+          for (i = 0; i < size; i++)
+            values[i].value = i / 2;
+          shuffle (values, size);
+          rb_init (&tree, value_less, NULL);
+          for (i = 0; i < size; i++)
+            {
+              values[i].seq = i;
+              rb_insert (&tree, &values[i].elem);
+              verify_tree (&tree, i + 1);
+            }
+
+          /* Remove them again, in a different random order.  The
+             elements are linked into the tree now, so shuffle
+             their indexes rather than the elements themselves. */
+          for (i = 0; i < size; i++)
+            order[i] = i;
+          shuffle_ints (order, size);
+          for (i = 0; i < size; i++)
+            {
+              rb_remove (&tree, &values[order[i]].elem);
+              verify_tree (&tree, size - i - 1);
+            }
+          ASSERT (rb_empty (&tree));
+          ASSERT (rb_min (&tree) == NULL);
+        }
+    }
+
+  printf (" done\n");
+  printf ("rbtree: PASS\n");
+}
+
+/* Shuffles the CNT elements in ARRAY into random order. */
+static void
+shuffle (struct value *array, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t j = i + random_ulong () % (cnt - i);
+      struct value t = array[j];
+      array[j] = array[i];
+      array[i] = t;
+    }
+}
+
+/* Shuffles the CNT elements in ARRAY into random order. */
+static void
+shuffle_ints (int *array, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t j = i + random_ulong () % (cnt - i);
+      int t = array[j];
+      array[j] = array[i];
+      array[i] = t;
+    }
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+value_less (const struct rb_elem *a_, const struct rb_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = rb_entry (a_, struct value, elem);
+  const struct value *b = rb_entry (b_, struct value, elem);
+
+  return a->value < b->value;
+}
+
+/* Verifies the parent links and red-black invariants of the
+   subtree rooted at E, and returns its black height. */
+static int
+verify_subtree (const struct rb_elem *e)
+{
+  int left, right;
+
+  if (e == NULL)
+    return 1;
+  if (e->left != NULL)
+    ASSERT (e->left->parent == e);
+  if (e->right != NULL)
+    ASSERT (e->right->parent == e);
+  if (e->red)
+    ASSERT ((e->left == NULL || !e->left->red)
+            && (e->right == NULL || !e->right->red));
+
+  left = verify_subtree (e->left);
+  right = verify_subtree (e->right);
+  ASSERT (left == right);
+  return left + !e->red;
+}
+
+/* Verifies that TREE holds SIZE elements in ascending order,
+   with equal values in insertion order, and that it is a valid
+   red-black tree. */
+static void
+verify_tree (struct rb_tree *tree, int size)
+{
+  struct rb_elem *e;
+  const struct value *prev = NULL;
+  int i;
+
+  ASSERT (rb_size (tree) == (size_t) size);
+  ASSERT (tree->root == NULL || (!tree->root->red
+                                 && tree->root->parent == NULL));
+  verify_subtree (tree->root);
+
+  for (i = 0, e = rb_min (tree); e != NULL; i++, e = rb_next (e))
+    {
+      const struct value *v = rb_entry (e, struct value, elem);
+      if (prev != NULL)
+        ASSERT (prev->value < v->value
+                || (prev->value == v->value && prev->seq < v->seq));
+      prev = v;
+    }
+  ASSERT (i == size);
+}
@@ -0,0 +1,97 @@
+/* Measures the cost of priority donation through chains of 1 to
+   8 locks.  For a chain of depth D, the main thread holds lock 0
+   and threads 1 to D - 1 each hold lock I while waiting on lock
+   I - 1, in increasing order of priority.  A final thread of
+   higher priority than all of them then blocks on lock D - 1,
+   donating its priority all the way down the chain to the main
+   thread.  The time from that lock_acquire() call to the main
+   thread running again is one sample. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define MAX_DEPTH 8
+#define ITERATIONS 20
+
+/* Locks for one thread in the chain. */
+struct chain_link
+  {
+    struct lock *hold;          /* Lock to hold, or null. */
+    struct lock *wait;          /* Lock to wait on. */
+    uint64_t *start;            /* If non-null, TSC before waiting. */
+  };
+
+static thread_func chain_thread;
+
+void
+test_bench_donate (void) 
+{
+  int depth;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (depth = 1; depth <= MAX_DEPTH; depth++)
+    {
+      struct bench_stats stats;
+      char name[32];
+      int iteration;
+
+      bench_init (&stats);
+      for (iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+          struct lock locks[MAX_DEPTH];
+          struct chain_link links[MAX_DEPTH + 1];
+          uint64_t start;
+          int i;
+
+          for (i = 0; i < depth; i++)
+            lock_init (&locks[i]);
+          lock_acquire (&locks[0]);
+
+          /* Each new thread preempts the main thread, takes its
+             own lock and blocks on the previous one. */
+          for (i = 1; i < depth; i++)
+            {
+              links[i].hold = &locks[i];
+              links[i].wait = &locks[i - 1];
+              links[i].start = NULL;
+              thread_create ("link", PRI_DEFAULT + i, chain_thread, &links[i]);
+            }
+
+          links[depth].hold = NULL;
+          links[depth].wait = &locks[depth - 1];
+          links[depth].start = &start;
+          thread_create ("donor", PRI_DEFAULT + depth, chain_thread,
+                         &links[depth]);
+          bench_add (&stats, rdtsc () - start);
+
+          /* Unwind the chain; every thread finishes before the
+             main thread, back at its own priority, runs again. */
+          lock_release (&locks[0]);
+        }
+
+      snprintf (name, sizeof name, "donate-depth-%d", depth);
+      bench_report (name, &stats);
+    }
+}
+
+/* A thread in the chain. */
+static void
+chain_thread (void *link_) 
+{
+  struct chain_link *link = link_;
+
+  if (link->hold != NULL)
+    lock_acquire (link->hold);
+  if (link->start != NULL)
+    *link->start = rdtsc ();
+  lock_acquire (link->wait);
+  lock_release (link->wait);
+  if (link->hold != NULL)
+    lock_release (link->hold);
+}
@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ('donate-depth-1', 'donate-depth-2', 'donate-depth-3', 'donate-depth-4', 'donate-depth-5', 'donate-depth-6', 'donate-depth-7', 'donate-depth-8');
+pass;
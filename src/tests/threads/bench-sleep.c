@@ -0,0 +1,52 @@
+/* Measures timer_sleep() jitter.  Sleeps for one tick at a time
+   and records the TSC interval between successive wake-ups.  On
+   an idle machine every interval should be one tick long; the
+   spread of the intervals around their mean is the jitter. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPS 200
+
+void
+test_bench_sleep (void) 
+{
+  struct bench_stats intervals, jitter;
+  uint64_t *wake;
+  uint64_t mean;
+  int i;
+
+  wake = malloc (sizeof *wake * (SLEEPS + 1));
+  if (wake == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  /* Start on a tick boundary. */
+  timer_sleep (1);
+  wake[0] = rdtsc ();
+  for (i = 1; i <= SLEEPS; i++)
+    {
+      timer_sleep (1);
+      wake[i] = rdtsc ();
+    }
+
+  bench_init (&intervals);
+  for (i = 1; i <= SLEEPS; i++)
+    bench_add (&intervals, wake[i] - wake[i - 1]);
+  mean = intervals.total / intervals.cnt;
+
+  bench_init (&jitter);
+  for (i = 1; i <= SLEEPS; i++)
+    {
+      uint64_t interval = wake[i] - wake[i - 1];
+      bench_add (&jitter, interval > mean ? interval - mean : mean - interval);
+    }
+
+  bench_report ("sleep-interval", &intervals);
+  bench_report ("sleep-jitter", &jitter);
+  free (wake);
+}
@@ -0,0 +1,54 @@
+/* Measures the cost of a context switch.  The main thread and a
+   helper thread of the same priority "ping-pong" control through
+   a pair of semaphores, so that every sema_up() switches to the
+   other thread.  Each round trip is two switches. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUND_TRIPS 1000
+
+static thread_func pong;
+
+void
+test_bench_switch (void) 
+{
+  struct semaphore sema[2];
+  struct bench_stats stats;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema[0], 0);
+  sema_init (&sema[1], 0);
+  thread_create ("pong", PRI_DEFAULT, pong, sema);
+
+  bench_init (&stats);
+  for (i = 0; i < ROUND_TRIPS; i++) 
+    {
+      uint64_t start = rdtsc ();
+      sema_up (&sema[0]);
+      sema_down (&sema[1]);
+      bench_add (&stats, (rdtsc () - start) / 2);
+    }
+  bench_report ("context-switch", &stats);
+}
+
+/* Helper thread that answers every ping. */
+static void
+pong (void *sema_) 
+{
+  struct semaphore *sema = sema_;
+  int i;
+
+  for (i = 0; i < ROUND_TRIPS; i++) 
+    {
+      sema_down (&sema[0]);
+      sema_up (&sema[1]);
+    }
+}
@@ -0,0 +1,132 @@
+/* Measures the cost of waking the highest priority thread out of
+   N threads waiting on a semaphore, a condition variable and a
+   lock, for several values of N.  The waiters have a mix of
+   priorities, all below the main thread's while it wakes them, so
+   each sample is the cost of sema_up(), cond_signal() or
+   lock_release() alone, without a thread switch. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUNDS 5
+
+/* State shared with the waiting threads. */
+static struct semaphore sema;
+static struct lock lock;
+static struct condition cond;
+
+static thread_func sema_waiter, cond_waiter, lock_waiter;
+static void run_round (int waiter_cnt, thread_func *,
+                       struct bench_stats *);
+
+void
+test_bench_waiters (void) 
+{
+  static const int waiter_cnts[] = {4, 16, 64};
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (i = 0; i < sizeof waiter_cnts / sizeof *waiter_cnts; i++)
+    {
+      struct bench_stats sema_stats, cond_stats, lock_stats;
+      char name[32];
+      int round;
+
+      bench_init (&sema_stats);
+      bench_init (&cond_stats);
+      bench_init (&lock_stats);
+      for (round = 0; round < ROUNDS; round++) 
+        {
+          run_round (waiter_cnts[i], sema_waiter, &sema_stats);
+          run_round (waiter_cnts[i], cond_waiter, &cond_stats);
+          run_round (waiter_cnts[i], lock_waiter, &lock_stats);
+        }
+
+      snprintf (name, sizeof name, "sema-up-%d", waiter_cnts[i]);
+      bench_report (name, &sema_stats);
+      snprintf (name, sizeof name, "cond-signal-%d", waiter_cnts[i]);
+      bench_report (name, &cond_stats);
+      snprintf (name, sizeof name, "lock-release-%d", waiter_cnts[i]);
+      bench_report (name, &lock_stats);
+    }
+}
+
+/* Starts WAITER_CNT threads running WAITER, which block, then
+   wakes them one at a time and adds the cost of each wake-up to
+   STATS. */
+static void
+run_round (int waiter_cnt, thread_func *waiter, struct bench_stats *stats) 
+{
+  int i;
+
+  sema_init (&sema, 0);
+  lock_init (&lock);
+  cond_init (&cond);
+
+  /* Each waiter has a higher priority than the main thread, so
+     it runs and blocks as soon as it is created. */
+  thread_set_priority (PRI_DEFAULT);
+  if (waiter == lock_waiter)
+    lock_acquire (&lock);
+  for (i = 0; i < waiter_cnt; i++) 
+    thread_create ("waiter", PRI_DEFAULT + 1 + i * 7 % 16, waiter, NULL);
+
+  /* Wake the waiters without letting them run. */
+  thread_set_priority (PRI_MAX);
+  if (waiter == lock_waiter)
+    {
+      uint64_t start = rdtsc ();
+      lock_release (&lock);
+      bench_add (stats, rdtsc () - start);
+    }
+  else
+    for (i = 0; i < waiter_cnt; i++) 
+      {
+        uint64_t start;
+
+        if (waiter == sema_waiter)
+          {
+            start = rdtsc ();
+            sema_up (&sema);
+            bench_add (stats, rdtsc () - start);
+          }
+        else
+          {
+            lock_acquire (&lock);
+            start = rdtsc ();
+            cond_signal (&cond, &lock);
+            bench_add (stats, rdtsc () - start);
+            lock_release (&lock);
+          }
+      }
+
+  /* Let the woken waiters run to completion. */
+  thread_set_priority (PRI_DEFAULT);
+}
+
+static void
+sema_waiter (void *aux UNUSED) 
+{
+  sema_down (&sema);
+}
+
+static void
+cond_waiter (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  cond_wait (&cond, &lock);
+  lock_release (&lock);
+}
+
+static void
+lock_waiter (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  lock_release (&lock);
+}
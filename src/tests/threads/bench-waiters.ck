@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ('sema-up-4', 'cond-signal-4', 'lock-release-4', 'sema-up-16', 'cond-signal-16', 'lock-release-16', 'sema-up-64', 'cond-signal-64', 'lock-release-64');
+pass;
@@ -0,0 +1,87 @@
+/* Measures wake-up latency, from sema_up() in the main thread to
+   the woken thread running, while N other threads sit ready in
+   the run queue, for several values of N.  The woken thread has
+   a higher priority than the main thread, which in turn has a
+   higher priority than the ready filler threads, so the fillers
+   never run until a round is over. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WAKEUPS 200
+
+/* State shared with the woken thread. */
+struct wakeup_info
+  {
+    struct semaphore wake;      /* Upped by the main thread. */
+    struct semaphore done;      /* Upped by the woken thread at exit. */
+    uint64_t start;             /* TSC just before sema_up(). */
+    struct bench_stats stats;   /* Measured latencies. */
+  };
+
+static thread_func waiter;
+static thread_func filler;
+
+void
+test_bench_wakeup (void) 
+{
+  static const int filler_cnts[] = {0, 16, 64, 256};
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (i = 0; i < sizeof filler_cnts / sizeof *filler_cnts; i++)
+    {
+      struct wakeup_info info;
+      char name[32];
+      int j;
+
+      for (j = 0; j < filler_cnts[i]; j++)
+        thread_create ("filler", PRI_DEFAULT - 1, filler, NULL);
+
+      sema_init (&info.wake, 0);
+      sema_init (&info.done, 0);
+      bench_init (&info.stats);
+      thread_create ("waiter", PRI_DEFAULT + 1, waiter, &info);
+
+      for (j = 0; j < WAKEUPS; j++)
+        {
+          info.start = rdtsc ();
+          sema_up (&info.wake);
+        }
+      sema_down (&info.done);
+
+      snprintf (name, sizeof name, "wakeup-ready-%d", filler_cnts[i]);
+      bench_report (name, &info.stats);
+
+      /* Let the fillers run to completion before the next round. */
+      timer_sleep (10);
+    }
+}
+
+/* Higher-priority thread that is woken WAKEUPS times. */
+static void
+waiter (void *info_) 
+{
+  struct wakeup_info *info = info_;
+  int i;
+
+  for (i = 0; i < WAKEUPS; i++)
+    {
+      sema_down (&info->wake);
+      bench_add (&info->stats, rdtsc () - info->start);
+    }
+  sema_up (&info->done);
+}
+
+/* Lower-priority thread that only occupies the run queue. */
+static void
+filler (void *aux UNUSED) 
+{
+}
@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+check_bench ('wakeup-ready-0', 'wakeup-ready-16', 'wakeup-ready-64', 'wakeup-ready-256');
+pass;
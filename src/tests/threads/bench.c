@@ -0,0 +1,44 @@
+/* Helpers shared by the bench-* tests.
+
+   Each benchmark reports its results as lines of the form
+     (TEST) BENCH NAME samples=N min=C avg=C max=C
+   where each C is a count of time-stamp counter cycles, so that
+   they can be picked out of the serial console output by a
+   script. */
+
+#include "tests/threads/bench.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+
+/* Initializes STATS with no samples. */
+void
+bench_init (struct bench_stats *stats)
+{
+  stats->cnt = 0;
+  stats->min = UINT64_MAX;
+  stats->max = 0;
+  stats->total = 0;
+}
+
+/* Adds a sample of CYCLES cycles to STATS. */
+void
+bench_add (struct bench_stats *stats, uint64_t cycles)
+{
+  stats->cnt++;
+  stats->total += cycles;
+  if (cycles < stats->min)
+    stats->min = cycles;
+  if (cycles > stats->max)
+    stats->max = cycles;
+}
+
+/* Reports STATS under NAME. */
+void
+bench_report (const char *name, const struct bench_stats *stats)
+{
+  if (stats->cnt == 0)
+    fail ("no samples for %s", name);
+  msg ("BENCH %s samples=%u min=%"PRIu64" avg=%"PRIu64" max=%"PRIu64,
+       name, stats->cnt, stats->min, stats->total / stats->cnt, stats->max);
+}
@@ -0,0 +1,28 @@
+#ifndef TESTS_THREADS_BENCH_H
+#define TESTS_THREADS_BENCH_H
+
+#include <stdint.h>
+
+/* Returns the CPU's time-stamp counter, in cycles since reset. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t low, high;
+  asm volatile ("rdtsc" : "=a" (low), "=d" (high));
+  return ((uint64_t) high << 32) | low;
+}
+
+/* Summary of a series of cycle counts. */
+struct bench_stats
+  {
+    unsigned cnt;               /* Number of samples. */
+    uint64_t min;               /* Smallest sample. */
+    uint64_t max;               /* Largest sample. */
+    uint64_t total;             /* Sum of all samples. */
+  };
+
+void bench_init (struct bench_stats *);
+void bench_add (struct bench_stats *, uint64_t cycles);
+void bench_report (const char *name, const struct bench_stats *);
+
+#endif /* tests/threads/bench.h */
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Checks that the test ran to completion and printed one BENCH
+# line, in order, for each of the given names.  The cycle counts
+# themselves depend on the host and are not checked.
+sub check_bench {
+    my (@names) = @_;
+    our ($test);
+    my ($run) = $test =~ m%([^/]+)$%;
+    my (@output) = read_text_file ("$test.output");
+
+    common_checks ("run", @output);
+    s/ (samples|min|avg|max)=\d+/ $1=N/g foreach @output;
+
+    my (@expected) = ("($run) begin",
+		      map ("($run) BENCH $_ samples=N min=N avg=N max=N",
+			   @names),
+		      "($run) end");
+    compare_output ("run", \@output, [join ("\n", @expected)]);
+}
+
+1;
@@ -0,0 +1,50 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::mlfqs;
+
+# Weight of each nice value from -20 to 20, as in threads/thread.c.
+my (@cfs_weights) = (88761, 71755, 56483, 46273, 36291,
+		     29154, 23254, 18705, 14949, 11916,
+		     9548, 7620, 6100, 4904, 3906,
+		     3121, 2501, 1991, 1586, 1277,
+		     1024, 820, 655, 526, 423,
+		     335, 272, 215, 172, 137,
+		     110, 87, 70, 56, 45,
+		     36, 29, 23, 18, 15,
+		     12);
+
+# Returns the ticks that threads with the given nice values
+# should receive out of 3000, in proportion to their weights.
+sub cfs_expected_ticks {
+    my (@nice) = @_;
+    my (@weight) = map ($cfs_weights[$_ + 20], @nice);
+    my ($total) = 0;
+    $total += $_ foreach @weight;
+    return map (3000 * $_ / $total, @weight);
+}
+
+sub check_cfs_fair {
+    my ($nice, $maxdiff) = @_;
+    our ($test);
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+
+    my (@actual);
+    local ($_);
+    foreach (@output) {
+	my ($id, $count) = /Thread (\d+) received (\d+) ticks\./ or next;
+        $actual[$id] = $count;
+    }
+
+    my (@expected) = cfs_expected_ticks (@$nice);
+    mlfqs_compare ("thread", "%d",
+		   \@actual, \@expected, $maxdiff, [0, $#$nice, 1],
+		   "Some tick counts were missing or differed from those "
+		   . "expected by more than $maxdiff.");
+    pass;
+}
+
+1;
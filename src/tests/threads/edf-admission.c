@@ -0,0 +1,53 @@
+/* Checks that admission control refuses to give real-time
+   threads more than the whole CPU, and that an exiting
+   real-time thread gives its share back. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func child_thread;
+
+void
+test_edf_admission (void) 
+{
+  struct semaphore done;
+
+  /* This test does not work with the MLFQS or CFS. */
+  ASSERT (!thread_mlfqs && !thread_cfs);
+
+  sema_init (&done, 0);
+  msg ("main: %s 6 ticks in 10.",
+       thread_set_deadline (10, 6) ? "admitted" : "rejected");
+
+  /* Child 2 is only admitted if child 1 gave its share back
+     when it exited.  Sleep to give each child time to exit. */
+  thread_create ("child 1", PRI_DEFAULT, child_thread, &done);
+  sema_down (&done);
+  timer_sleep (TIMER_FREQ / 10);
+  thread_create ("child 2", PRI_DEFAULT, child_thread, &done);
+  sema_down (&done);
+  timer_sleep (TIMER_FREQ / 10);
+
+  msg ("main: %s 10 ticks in 10.",
+       thread_set_deadline (10, 10) ? "admitted" : "rejected");
+  msg ("main: %s normal scheduling.",
+       thread_set_deadline (0, 0) ? "returned to" : "refused");
+}
+
+static void
+child_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  msg ("%s: %s 5 ticks in 10.", thread_name (),
+       thread_set_deadline (10, 5) ? "admitted" : "rejected");
+  msg ("%s: %s 4 ticks in 10.", thread_name (),
+       thread_set_deadline (10, 4) ? "admitted" : "rejected");
+  msg ("%s: %s 9 ticks in 20.", thread_name (),
+       thread_set_deadline (20, 9) ? "admitted" : "rejected");
+  sema_up (done);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admission) begin
+(edf-admission) main: admitted 6 ticks in 10.
+(edf-admission) child 1: rejected 5 ticks in 10.
+(edf-admission) child 1: admitted 4 ticks in 10.
+(edf-admission) child 1: rejected 9 ticks in 20.
+(edf-admission) child 2: rejected 5 ticks in 10.
+(edf-admission) child 2: admitted 4 ticks in 10.
+(edf-admission) child 2: rejected 9 ticks in 20.
+(edf-admission) main: admitted 10 ticks in 10.
+(edf-admission) main: returned to normal scheduling.
+(edf-admission) end
+EOF
+pass;
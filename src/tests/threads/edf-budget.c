@@ -0,0 +1,72 @@
+/* Checks that a real-time thread cannot run for more than its
+   budget.  A real-time thread that never stops running is given
+   2 ticks in every period of 10 ticks, so over 50 periods it
+   should get about 100 ticks, leaving the rest of the CPU to the
+   main thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define PERIOD 10
+#define BUDGET 2
+#define PERIOD_CNT 50
+
+static thread_func hog_thread;
+static volatile bool stop;
+static struct semaphore started, done;
+static int hog_ticks;
+
+void
+test_edf_budget (void) 
+{
+  int64_t start_time;
+  int expected = BUDGET * PERIOD_CNT;
+
+  /* This test does not work with the MLFQS or CFS. */
+  ASSERT (!thread_mlfqs && !thread_cfs);
+
+  stop = false;
+  sema_init (&started, 0);
+  sema_init (&done, 0);
+  thread_create ("hog", PRI_DEFAULT, hog_thread, NULL);
+  sema_down (&started);
+
+  /* Spin alongside the real-time thread. */
+  msg ("Spinning for %d ticks...", PERIOD * PERIOD_CNT);
+  start_time = timer_ticks ();
+  while (timer_elapsed (start_time) < PERIOD * PERIOD_CNT)
+    continue;
+  stop = true;
+  sema_down (&done);
+
+  if (hog_ticks < expected - expected / 10
+      || hog_ticks > expected + expected / 10)
+    fail ("real-time thread ran for %d ticks, expected about %d",
+          hog_ticks, expected);
+  msg ("Real-time thread stayed within its budget.");
+}
+
+static void
+hog_thread (void *aux UNUSED) 
+{
+  int64_t last_time;
+
+  if (!thread_set_deadline (PERIOD, BUDGET))
+    fail ("real-time thread not admitted");
+  sema_up (&started);
+
+  /* Count the ticks on which this thread is running. */
+  last_time = timer_ticks ();
+  while (!stop) 
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        hog_ticks++;
+      last_time = cur_time;
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-budget) begin
+(edf-budget) Spinning for 500 ticks...
+(edf-budget) Real-time thread stayed within its budget.
+(edf-budget) end
+EOF
+pass;
@@ -0,0 +1,122 @@
+/* Checks that real-time threads meet their deadlines while
+   CPU-bound threads at the highest priority compete for the
+   CPU.
+
+   Each real-time thread is released once per period, at which
+   point it needs a few ticks of CPU time, fewer than its budget,
+   to finish its work.  The work must be finished by the end of
+   the period. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of CPU-bound threads. */
+#define LOAD_CNT 4
+
+/* Number of periods each real-time thread runs for. */
+#define PERIOD_CNT 10
+
+struct rt_info 
+  {
+    int64_t period;             /* Period, in ticks. */
+    int64_t budget;             /* Budget per period, in ticks. */
+    int work;                   /* Ticks of work per period. */
+    int met;                    /* Number of deadlines met. */
+    struct semaphore done;      /* Upped when the thread finishes. */
+  };
+
+static thread_func rt_thread, load_thread;
+static volatile bool stop;
+static struct semaphore load_done;
+
+void
+test_edf_deadline (void) 
+{
+  static const int periods[] = {20, 30, 50};
+  static const int budgets[] = {4, 6, 10};
+  static const int works[] = {2, 3, 5};
+  const int rt_cnt = sizeof periods / sizeof *periods;
+  struct rt_info info[sizeof periods / sizeof *periods];
+  int i;
+
+  /* This test does not work with the MLFQS or CFS. */
+  ASSERT (!thread_mlfqs && !thread_cfs);
+
+  thread_set_priority (PRI_MAX);
+  stop = false;
+  sema_init (&load_done, 0);
+  for (i = 0; i < LOAD_CNT; i++) 
+    thread_create ("load", PRI_MAX, load_thread, NULL);
+
+  for (i = 0; i < rt_cnt; i++) 
+    {
+      char name[16];
+
+      info[i].period = periods[i];
+      info[i].budget = budgets[i];
+      info[i].work = works[i];
+      info[i].met = 0;
+      sema_init (&info[i].done, 0);
+      snprintf (name, sizeof name, "rt %d", i);
+      thread_create (name, PRI_MAX, rt_thread, &info[i]);
+    }
+
+  for (i = 0; i < rt_cnt; i++)
+    {
+      sema_down (&info[i].done);
+      msg ("Real-time thread %d met %d of %d deadlines.",
+           i, info[i].met, PERIOD_CNT);
+    }
+
+  stop = true;
+  for (i = 0; i < LOAD_CNT; i++)
+    sema_down (&load_done);
+}
+
+/* Runs WORK ticks of work in every period of the real-time
+   thread described by AUX, and counts the deadlines it meets. */
+static void
+rt_thread (void *info_) 
+{
+  struct rt_info *info = info_;
+  int64_t release;
+  int i;
+
+  if (!thread_set_deadline (info->period, info->budget))
+    fail ("thread %s not admitted", thread_name ());
+
+  release = timer_ticks ();
+  for (i = 0; i < PERIOD_CNT; i++) 
+    {
+      int64_t last_time;
+      int work = 0;
+
+      /* Busy-wait until WORK ticks of CPU time have gone by. */
+      timer_sleep (release - timer_ticks ());
+      last_time = timer_ticks ();
+      while (work < info->work) 
+        {
+          int64_t cur_time = timer_ticks ();
+          if (cur_time != last_time)
+            work++;
+          last_time = cur_time;
+        }
+
+      if (timer_ticks () <= release + info->period)
+        info->met++;
+      release += info->period;
+    }
+  sema_up (&info->done);
+}
+
+static void
+load_thread (void *aux UNUSED) 
+{
+  while (!stop)
+    barrier ();
+  sema_up (&load_done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-deadline) begin
+(edf-deadline) Real-time thread 0 met 10 of 10 deadlines.
+(edf-deadline) Real-time thread 1 met 10 of 10 deadlines.
+(edf-deadline) Real-time thread 2 met 10 of 10 deadlines.
+(edf-deadline) end
+EOF
+pass;
@@ -0,0 +1,54 @@
+/* Tests that readers share a readers-writer lock, that a writer
+   keeps out readers that arrive after it even if their priority
+   is higher, and that they donate their priority to the writer
+   while they wait. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread;
+static thread_func writer_thread;
+static struct rwlock rwlock;
+
+void
+test_priority_rwlock (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rwlock);
+  rwlock_acquire_read (&rwlock);
+  msg ("main holds the lock for reading.");
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_thread, NULL);
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread, NULL);
+  thread_create ("reader 2", PRI_DEFAULT + 3, reader_thread, NULL);
+  msg ("main releasing the lock.");
+  rwlock_release_read (&rwlock);
+  msg ("main done.");
+}
+
+static void
+reader_thread (void *aux UNUSED) 
+{
+  msg ("%s acquiring the lock for reading.", thread_name ());
+  rwlock_acquire_read (&rwlock);
+  msg ("%s got in.", thread_name ());
+  rwlock_release_read (&rwlock);
+  msg ("%s done.", thread_name ());
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  msg ("writer acquiring the lock for writing.");
+  rwlock_acquire_write (&rwlock);
+  msg ("writer got in with priority %d.", thread_get_priority ());
+  rwlock_release_write (&rwlock);
+  msg ("writer done.");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-rwlock) begin
+(priority-rwlock) main holds the lock for reading.
+(priority-rwlock) reader 1 acquiring the lock for reading.
+(priority-rwlock) reader 1 got in.
+(priority-rwlock) reader 1 done.
+(priority-rwlock) writer acquiring the lock for writing.
+(priority-rwlock) reader 2 acquiring the lock for reading.
+(priority-rwlock) main releasing the lock.
+(priority-rwlock) writer got in with priority 34.
+(priority-rwlock) reader 2 got in.
+(priority-rwlock) reader 2 done.
+(priority-rwlock) writer done.
+(priority-rwlock) main done.
+(priority-rwlock) end
+EOF
+pass;
@@ -0,0 +1,62 @@
+/* Measures the cost of a page fault.  Touches each page of a
+   buffer in the BSS once, timing the first touch, which faults
+   the page in, and then a second touch of the now resident page.
+   The buffer is small enough to fit in memory, so that no fault
+   waits for an eviction.
+
+   Reports its results as lines of the form
+     (bench-fault) BENCH NAME samples=N min=C avg=C max=C
+   where each C is a count of time-stamp counter cycles. */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 128
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Returns the CPU's time-stamp counter, in cycles since reset. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t low, high;
+  asm volatile ("rdtsc" : "=a" (low), "=d" (high));
+  return ((uint64_t) high << 32) | low;
+}
+
+/* Touches every page of BUF, timing each touch, and reports the
+   results under NAME. */
+static void
+touch_pages (const char *name)
+{
+  volatile char *page = buf;
+  uint64_t min = UINT64_MAX, max = 0, total = 0;
+  size_t i;
+
+  for (i = 0; i < PAGE_CNT; i++, page += PAGE_SIZE)
+    {
+      uint64_t start = rdtsc ();
+      uint64_t cycles;
+
+      *page = 1;
+      cycles = rdtsc () - start;
+      total += cycles;
+      if (cycles < min)
+        min = cycles;
+      if (cycles > max)
+        max = cycles;
+    }
+
+  msg ("BENCH %s samples=%d min=%"PRIu64" avg=%"PRIu64" max=%"PRIu64,
+       name, PAGE_CNT, min, total / PAGE_CNT, max);
+}
+
+void
+test_main (void)
+{
+  touch_pages ("fault-in");
+  touch_pages ("resident");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+
+# The cycle counts depend on the host and are not checked.
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/ (samples|min|avg|max)=\d+/ $1=N/g foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(bench-fault) begin
+(bench-fault) BENCH fault-in samples=N min=N avg=N max=N
+(bench-fault) BENCH resident samples=N min=N avg=N max=N
+(bench-fault) end
+EOF
+pass;
@@ -0,0 +1,85 @@
+/* Forks children that write to the pages they share copy-on-write
+   with their parent, and checks that each process goes on seeing
+   only its own writes.  Then forks a child that waits while the
+   parent writes to the pages they still share, and checks that
+   the child keeps the original bytes. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+#define CHILD_CNT 4
+
+static char buf[SIZE];
+
+/* Checks that every byte of BUF is the one written by
+   fill (VALUE). */
+static bool
+check (int value)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != (char) (i % 251 + value))
+      return false;
+  return true;
+}
+
+/* Fills BUF with a pattern that depends on VALUE. */
+static void
+fill (int value)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    buf[i] = i % 251 + value;
+}
+
+void
+test_main (void)
+{
+  pid_t pid;
+  int i;
+
+  fill (0);
+  for (i = 1; i <= CHILD_CNT; i++)
+    {
+      pid = fork ();
+      if (pid == 0)
+        {
+          /* The child sees its parent's memory, then its own
+             writes. */
+          if (!check (0))
+            fail ("child %d does not see parent's data", i);
+          fill (i);
+          if (!check (i))
+            fail ("child %d does not see its own writes", i);
+          exit (i);
+        }
+      CHECK (pid != -1, "fork child %d", i);
+      CHECK (wait (pid) == i, "wait for child %d", i);
+      CHECK (check (0), "parent's data unchanged");
+    }
+
+  /* This time the parent writes first, while the child still
+     shares every page, and creates a file to tell the child it is
+     done. */
+  pid = fork ();
+  if (pid == 0)
+    {
+      int fd;
+
+      while ((fd = open ("parent-wrote")) == -1)
+        continue;
+      close (fd);
+      if (!check (0))
+        fail ("child sees parent's writes");
+      exit (CHILD_CNT + 1);
+    }
+  CHECK (pid != -1, "fork child %d", CHILD_CNT + 1);
+  fill (CHILD_CNT + 1);
+  CHECK (check (CHILD_CNT + 1), "parent sees its own writes");
+  CHECK (create ("parent-wrote", 0), "create \"parent-wrote\"");
+  CHECK (wait (pid) == CHILD_CNT + 1, "wait for child %d", CHILD_CNT + 1);
+}
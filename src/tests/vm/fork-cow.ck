@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fork-cow) begin
+(fork-cow) fork child 1
+(fork-cow) wait for child 1
+(fork-cow) parent's data unchanged
+(fork-cow) fork child 2
+(fork-cow) wait for child 2
+(fork-cow) parent's data unchanged
+(fork-cow) fork child 3
+(fork-cow) wait for child 3
+(fork-cow) parent's data unchanged
+(fork-cow) fork child 4
+(fork-cow) wait for child 4
+(fork-cow) parent's data unchanged
+(fork-cow) fork child 5
+(fork-cow) parent sees its own writes
+(fork-cow) create "parent-wrote"
+(fork-cow) wait for child 5
+(fork-cow) end
+EOF
+pass;
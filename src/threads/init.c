@@ -35,6 +35,7 @@
 #ifdef VM
 #include "vm/frame.h"
 #include "devices/swap.h"
+#include "vm/zswap.h"
 #include "userprog/mapId.h"
 #endif
 #ifdef FILESYS
@@ -139,6 +140,7 @@ main (void)
 #ifdef VM
   /* Initialise the swap disk */  
   swap_init ();
+  zswap_init ();
   frame_table_init ();
   mmap_init ();
 #endif
@@ -272,13 +274,25 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-cfs"))
+        thread_cfs = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
+      else if (!strcmp (name, "-wheel"))
+        timer_wheel_bits = atoi (value);
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-fa"))
+        fault_around_pages = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
     }
+  if (thread_mlfqs && thread_cfs)
+    PANIC ("-mlfqs and -cfs cannot be used together");
 
   /* Initialize the random number generator based on the system
      time.  This has no effect if an "-rs" option was specified.
@@ -395,8 +409,14 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -cfs               Use completely fair scheduler.\n"
+          "  -tickless          Stop the timer tick while the CPU is idle.\n"
+          "  -wheel=BITS        Give each timer wheel level 2**BITS slots.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -fa=COUNT          Map up to COUNT file pages per page fault.\n"
 #endif
           );
   shutdown_power_off ();
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -23,13 +24,21 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   When nothing else is ready to run, the idle thread zeroes free
+   pages of the user pool ahead of time, so that most PAL_ZERO
+   requests for user pages need not.  A free page already zeroed
+   is marked in the pool's zeroed_map, and also in its used_map so
+   that requests that do not want zeros leave it alone while
+   there are other free pages. */
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct bitmap *zeroed_map;          /* Bitmap of zeroed free pages. */
     uint8_t *base;                      /* Base of pool. */
   };
 
@@ -39,6 +48,7 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static void unzero_pool (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -72,13 +82,32 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
-  size_t page_idx;
+  size_t page_idx = BITMAP_ERROR;
+  bool zeroed = false;
 
   if (page_cnt == 0)
     return NULL;
 
   lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+  if (page_cnt == 1 && (flags & PAL_ZERO) && (flags & PAL_USER))
+    {
+      page_idx = bitmap_scan_and_flip (pool->zeroed_map, 0, 1, true);
+      zeroed = page_idx != BITMAP_ERROR;
+    }
+  if (!zeroed)
+    page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+  if (page_idx == BITMAP_ERROR && page_cnt == 1)
+    {
+      /* Only zeroed pages are left. */
+      page_idx = bitmap_scan_and_flip (pool->zeroed_map, 0, 1, true);
+      zeroed = page_idx != BITMAP_ERROR;
+    }
+  else if (page_idx == BITMAP_ERROR)
+    {
+      /* Zeroed pages may be in the way of a run of free pages. */
+      unzero_pool (pool);
+      page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+    }
   lock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
@@ -88,7 +117,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else 
@@ -148,15 +177,67 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Zeroes a free page of the user pool that is not zeroed yet,
+   for a later PAL_ZERO request to take.  Returns false if there
+   is no such page.
+
+   Called by the idle thread, which must not block, so instead of
+   taking the pool's lock this touches the pool only with
+   interrupts off and while no other thread holds the lock.  Must
+   be called with interrupts off, and returns with them off, but
+   turns them on while zeroing, so that any thread that becomes
+   ready preempts it. */
+bool
+palloc_zero_free_page (void)
+{
+  struct pool *pool = &user_pool;
+  size_t page_idx;
+  void *page;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (pool->lock.holder != NULL)
+    return false;
+  page_idx = bitmap_scan_and_flip (pool->used_map, 0, 1, false);
+  if (page_idx == BITMAP_ERROR)
+    return false;
+
+  /* The page is marked used while it is zeroed, so that no one
+     else takes it. */
+  page = pool->base + PGSIZE * page_idx;
+  intr_enable ();
+  memset (page, 0, PGSIZE);
+  intr_disable ();
+
+  bitmap_mark (pool->zeroed_map, page_idx);
+  return true;
+}
+
+/* Returns the address of the first page in the user pool.  The
+   pool's pages follow it contiguously. */
+void *
+palloc_user_base (void)
+{
+  return user_pool.base;
+}
+
+/* Returns the number of pages in the user pool. */
+size_t
+palloc_user_page_cnt (void)
+{
+  return bitmap_size (user_pool.used_map);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's used_map and zeroed_map at its base.
+     Calculate the space needed for the bitmaps
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t bm_pages = DIV_ROUND_UP (2 * bm_size, PGSIZE);
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
@@ -165,7 +246,8 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
 
   /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->zeroed_map = bitmap_create_in_buf (page_cnt, base + bm_size, bm_size);
   p->base = base + bm_pages * PGSIZE;
 }
 
@@ -180,3 +262,19 @@ page_from_pool (const struct pool *pool, void *page)
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Gives the zeroed free pages of POOL back to the free pages
+   that are not known to be zero.  Must be called with POOL's
+   lock held. */
+static void
+unzero_pool (struct pool *pool)
+{
+  size_t page_idx;
+
+  for (page_idx = 0; page_idx < bitmap_size (pool->zeroed_map); page_idx++)
+    if (bitmap_test (pool->zeroed_map, page_idx))
+      {
+        bitmap_reset (pool->zeroed_map, page_idx);
+        bitmap_reset (pool->used_map, page_idx);
+      }
+}
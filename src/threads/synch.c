@@ -32,6 +32,10 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+static bool compare_waiter_priority (const struct heap_elem *,
+                                     const struct heap_elem *, void *aux);
+static void lock_take (struct lock *);
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,7 +51,19 @@ sema_init (struct semaphore *sema, unsigned value)
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  heap_init (&sema->waiters, compare_waiter_priority, NULL);
+}
+
+/* Compares priorities of two threads in a semaphore's waiters,
+   returns true if priority of thread A is greater than priority
+   of thread B. */
+static bool
+compare_waiter_priority (const struct heap_elem *first,
+                         const struct heap_elem *second, void *aux UNUSED)
+{
+  const struct thread *thread_a = heap_entry (first, struct thread, wait_elem);
+  const struct thread *thread_b = heap_entry (second, struct thread, wait_elem);
+  return thread_a->priority > thread_b->priority;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -68,7 +84,8 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      list_insert_ordered (&sema->waiters, &thread_current ()->elem, &compare_priority, NULL);
+      thread_current ()->waiting_sema = sema;
+      heap_push (&sema->waiters, &thread_current ()->wait_elem);
       thread_block ();
     }
   sema->value--;
@@ -102,7 +119,12 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up one thread of those waiting for SEMA, if any: the
+   one with the highest priority, or the one that has waited
+   longest among those of equal priority.  A waiter's place is
+   fixed by its priority when it started waiting, raised by any
+   donation since, so under -mlfqs the recent_cpu decay that
+   blocked threads fold in lazily does not reorder the waiters.
 
    This function may be called from an interrupt handler. */
 void
@@ -116,13 +138,11 @@ sema_up (struct semaphore *sema)
 
   sema->value++;
 
-  if (!list_empty (&sema->waiters)) {
-    if (thread_mlfqs)
-      thread_forin (&calculate_priority, &sema->waiters, NULL);
-    list_sort (&sema->waiters, &compare_priority, NULL);
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
-  
+  if (!heap_empty (&sema->waiters)) {
+    struct thread *t = heap_entry (heap_pop (&sema->waiters),
+                                   struct thread, wait_elem);
+    t->waiting_sema = NULL;
+    thread_unblock (t);
   }
   
   intr_set_level (old_level);
@@ -165,6 +185,146 @@ sema_test_helper (void *sema_)
     }
 }
 
+/* State shared by rwlock_self_test() and its helper threads. */
+struct rwlock_test
+  {
+    struct rwlock rwlock;       /* Lock under test. */
+    struct semaphore done;      /* Upped by each helper as it exits. */
+    char order[4];              /* Helpers, in the order they got in. */
+    int order_cnt;              /* Number of helpers that got in. */
+  };
+
+static void rwlock_test_reader (void *test_);
+static void rwlock_test_writer (void *test_);
+
+/* Self-test for readers-writer locks.  Relies on the priority
+   scheduler running a newly created thread of higher priority
+   at once, and checks that:
+
+   - a reader gets in while the test thread holds the lock for
+     reading;
+
+   - a writer then waits for the test thread, which can still
+     take the lock for reading again;
+
+   - a reader that arrives after the writer gets in only once
+     the writer is done, even though its priority is higher. */
+void
+rwlock_self_test (void)
+{
+  struct rwlock_test test;
+
+  printf ("Testing readers-writer locks...");
+  rwlock_init (&test.rwlock);
+  sema_init (&test.done, 0);
+  test.order_cnt = 0;
+
+  rwlock_acquire_read (&test.rwlock);
+  thread_create ("rw-reader", PRI_DEFAULT + 1, rwlock_test_reader, &test);
+  ASSERT (test.order_cnt == 1);
+  sema_down (&test.done);
+
+  thread_create ("rw-writer", PRI_DEFAULT + 1, rwlock_test_writer, &test);
+  thread_create ("rw-reader", PRI_DEFAULT + 2, rwlock_test_reader, &test);
+  ASSERT (test.order_cnt == 1);
+
+  rwlock_acquire_read (&test.rwlock);
+  rwlock_release_read (&test.rwlock);
+  rwlock_release_read (&test.rwlock);
+  sema_down (&test.done);
+  sema_down (&test.done);
+  ASSERT (test.order_cnt == 3 && !memcmp (test.order, "rwr", 3));
+  printf ("done.\n");
+}
+
+/* Reader thread used by rwlock_self_test(). */
+static void
+rwlock_test_reader (void *test_)
+{
+  struct rwlock_test *test = test_;
+
+  rwlock_acquire_read (&test->rwlock);
+  test->order[test->order_cnt++] = 'r';
+  rwlock_release_read (&test->rwlock);
+  sema_up (&test->done);
+}
+
+/* Writer thread used by rwlock_self_test(). */
+static void
+rwlock_test_writer (void *test_)
+{
+  struct rwlock_test *test = test_;
+
+  rwlock_acquire_write (&test->rwlock);
+  test->order[test->order_cnt++] = 'w';
+  rwlock_release_write (&test->rwlock);
+  sema_up (&test->done);
+}
+
+/* State shared by seqlock_self_test() and its helper thread. */
+struct seqlock_test
+  {
+    struct seqlock seqlock;     /* Lock under test. */
+    int a, b;                   /* Equal except during a write. */
+    bool done;                  /* Writer finished? */
+  };
+
+static void seqlock_test_writer (void *test_);
+
+/* Self-test for sequence locks.  A writer of equal priority
+   keeps a pair of counters equal, yielding after every write,
+   while the test thread yields between reading the two, so that
+   reads overlap writes and have to be retried. */
+void
+seqlock_self_test (void)
+{
+  struct seqlock_test test;
+  int retries = 0;
+
+  printf ("Testing sequence locks...");
+  seqlock_init (&test.seqlock);
+  test.a = test.b = 0;
+  test.done = false;
+  thread_create ("seq-writer", PRI_DEFAULT, seqlock_test_writer, &test);
+  while (!test.done)
+    {
+      unsigned seq;
+      int a, b;
+
+      for (;;)
+        {
+          seq = seqlock_read_begin (&test.seqlock);
+          a = test.a;
+          thread_yield ();
+          b = test.b;
+          if (!seqlock_read_retry (&test.seqlock, seq))
+            break;
+          retries++;
+        }
+      ASSERT (a == b);
+    }
+  ASSERT (retries > 0);
+  printf ("done.\n");
+}
+
+/* Writer thread used by seqlock_self_test(). */
+static void
+seqlock_test_writer (void *test_)
+{
+  struct seqlock_test *test = test_;
+  int i;
+
+  for (i = 0; i < 100; i++)
+    {
+      seqlock_write_begin (&test->seqlock);
+      test->a++;
+      test->b++;
+      seqlock_write_end (&test->seqlock);
+      thread_yield ();
+    }
+  test->done = true;
+}
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
@@ -193,10 +353,10 @@ lock_init (struct lock *lock)
 /* Compares max priority of two locks, 
 returns true if priority of lock A is greater than priority of lock B */
 bool 
-compare_lock_priority (const struct list_elem *first, const struct list_elem *second, void *aux UNUSED)
+compare_lock_priority (const struct heap_elem *first, const struct heap_elem *second, void *aux UNUSED)
 {
-  const struct lock *lock_a = list_entry (first, struct lock, elem);
-  const struct lock *lock_b = list_entry (second, struct lock, elem);
+  const struct lock *lock_a = heap_entry (first, struct lock, elem);
+  const struct lock *lock_b = heap_entry (second, struct lock, elem);
   return lock_a->max_priority > lock_b->max_priority;
 }
 
@@ -225,9 +385,10 @@ lock_acquire (struct lock *lock)
     if (lock->holder != NULL && curr->priority > lock->holder->priority) {
       curr->waiting_on = lock;
       temp_lock = lock;
-      while (temp_lock != NULL && curr->priority > temp_lock->max_priority) {
+      while (temp_lock != NULL && temp_lock->holder != NULL
+             && curr->priority > temp_lock->max_priority) {
         temp_lock->max_priority = curr->priority;
-        list_resort(&lock->holder->locks, &lock->elem, &compare_lock_priority);
+        heap_promote (&temp_lock->holder->locks, &temp_lock->elem);
         donate (temp_lock->holder, curr->priority);
         temp_lock = temp_lock->holder->waiting_on;
       }
@@ -239,11 +400,26 @@ lock_acquire (struct lock *lock)
   /* Calls thread_block, allowing donated thread to run */
   sema_down (&lock->semaphore);
   curr->waiting_on = NULL;
-  lock->holder = curr;
+  lock_take (lock);
+}
 
-  /* Add to the list of thread's held locks. */
+/* Makes the current thread the holder of LOCK, which it has just
+   downed the semaphore of.  LOCK's max_priority is recomputed
+   from the threads still waiting for it before LOCK joins the
+   thread's held locks. */
+static void
+lock_take (struct lock *lock)
+{
+  enum intr_level old_level = intr_disable ();
+  struct heap_elem *top = heap_top (&lock->semaphore.waiters);
+
+  lock->holder = thread_current ();
+  lock->max_priority = (top != NULL
+                        ? heap_entry (top, struct thread, wait_elem)->priority
+                        : PRI_MIN);
   thread_add_lock (lock);
 
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -262,7 +438,7 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success) {
-    lock->holder = thread_current ();
+    lock_take (lock);
   }
   return success;
 }
@@ -282,10 +458,6 @@ lock_release (struct lock *lock)
   lock->holder = NULL;
   sema_up (&lock->semaphore);
 
-  /* Revert lock max_priority to highest priority in waiters list. */
-  if (!list_empty (&(lock->semaphore.waiters)))
-    lock->max_priority = list_entry (list_front (&(lock->semaphore.waiters)), struct thread, elem)->priority;
-
   /* Revoke thread donation (if any) */
   revoke_donation ();
 
@@ -302,33 +474,23 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* One semaphore in a heap. */
 struct semaphore_elem 
   {
-    struct list_elem elem;              /* List element. */
+    struct heap_elem elem;              /* Heap element. */
     struct semaphore semaphore;         /* This semaphore. */
-    int priority;
+    int priority;                       /* Waiting thread's priority. */
   };
 
-  /* Compares max priority of two locks, 
-returns true if priority of sema A is greater than priority of sema B */
+/* Compares priorities of the threads waiting on two semaphores,
+   returns true if priority of sema A is greater than priority of sema B */
 static bool
-compare_sema_priority (const struct list_elem *first, const struct list_elem *second, void *aux UNUSED)
+compare_sema_priority (const struct heap_elem *first, const struct heap_elem *second, void *aux UNUSED)
 {
-  struct list *waiters_a, *waiters_b;
+  const struct semaphore_elem *sema_a = heap_entry (first, struct semaphore_elem, elem);
+  const struct semaphore_elem *sema_b = heap_entry (second, struct semaphore_elem, elem);
 
-  waiters_a = &(list_entry (first, struct semaphore_elem, elem))->semaphore.waiters;
-  waiters_b = &(list_entry (second, struct semaphore_elem, elem))->semaphore.waiters;
-
-  if (list_empty (waiters_a))
-    return true;
-  else if (list_empty (waiters_b))
-    return false;
-
-  struct thread *thread_a = list_entry (list_front (waiters_a), struct thread, elem);
-  struct thread *thread_b = list_entry (list_front (waiters_b), struct thread, elem);
-
-  return thread_a->priority > thread_b->priority;
+  return sema_a->priority > sema_b->priority;
 }
 
 /* Initializes condition variable COND.  A condition variable
@@ -339,7 +501,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  heap_init (&cond->waiters, compare_sema_priority, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -373,10 +535,11 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
+  waiter.priority = thread_current ()->priority;
 
   enum intr_level old_level = intr_disable ();
 
-  list_insert_ordered (&cond->waiters, &waiter.elem, &compare_sema_priority, NULL);
+  heap_push (&cond->waiters, &waiter.elem);
 
   intr_set_level(old_level);
 
@@ -386,7 +549,8 @@ cond_wait (struct condition *cond, struct lock *lock)
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
+   this function signals one of them to wake up from its wait:
+   the one whose priority was highest when it started waiting.
    LOCK must be held before calling this function.
 
    An interrupt handler cannot acquire a lock, so it does not
@@ -400,9 +564,8 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters)) {
-    list_sort (&cond->waiters, &compare_sema_priority, NULL);
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
+  if (!heap_empty (&cond->waiters)) {
+    sema_up (&heap_entry (heap_pop (&cond->waiters),
                           struct semaphore_elem, elem)->semaphore);
   }
   
@@ -420,6 +583,201 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!heap_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW as a readers-writer lock that no thread
+   holds. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  rw->writer = NULL;
+  rw->readers = 0;
+  rw->writer_waiting = false;
+  sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   waits for it.  The current thread must not hold RW for
+   writing.
+
+   A thread that already holds some readers-writer lock for
+   reading only waits for a writer that holds RW, not for one
+   that is waiting, so that it can take RW again without
+   deadlocking against a writer that is waiting for it: for
+   example, when a read system call takes a page fault that
+   reads the page in from the file system.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != cur);
+
+  old_level = intr_disable ();
+  if (cur->read_locks > 0 && rw->writer == NULL)
+    {
+      rw->readers++;
+      cur->read_locks++;
+      intr_set_level (old_level);
+      return;
+    }
+  intr_set_level (old_level);
+
+  /* Queue up behind the writer, if any, donating to it. */
+  lock_acquire (&rw->lock);
+  old_level = intr_disable ();
+  rw->readers++;
+  cur->read_locks++;
+  intr_set_level (old_level);
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for reading.  The
+   last reader out lets in a writer waiting for the readers to
+   drain. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (rw->readers > 0);
+  ASSERT (cur->read_locks > 0);
+  cur->read_locks--;
+  if (--rw->readers == 0 && rw->writer_waiting)
+    {
+      rw->writer_waiting = false;
+      sema_up (&rw->drained);
+    }
+  intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  New readers wait from the moment the writer arrives.
+   Threads that wait behind the writer donate their priority to
+   it, but a writer waiting for readers to drain does not donate
+   to the readers.  The current thread must not hold RW at all.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->lock);
+  old_level = intr_disable ();
+  while (rw->readers > 0)
+    {
+      rw->writer_waiting = true;
+      sema_down (&rw->drained);
+    }
+  rw->writer = thread_current ();
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_write_held_by_current_thread (rw));
+
+  rw->writer = NULL;
+  lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_write_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+/* Initializes sequence lock SL. */
+void
+seqlock_init (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+
+  sl->seq = 0;
+}
+
+/* Begins a write to the data SL protects.  Interrupts stay off
+   until the matching seqlock_write_end(), so no other writer can
+   begin meanwhile. */
+void
+seqlock_write_begin (struct seqlock *sl)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ASSERT ((sl->seq & 1) == 0);
+  sl->old_level = old_level;
+  sl->seq++;
+  barrier ();
+}
+
+/* Ends a write begun by seqlock_write_begin(), and restores the
+   interrupt level from before it began. */
+void
+seqlock_write_end (struct seqlock *sl)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (sl->seq & 1);
+
+  barrier ();
+  sl->seq++;
+  intr_set_level (sl->old_level);
+}
+
+/* Returns the sequence number to pass to seqlock_read_retry()
+   once the data SL protects has been copied, first waiting for
+   any write in progress to finish.
+
+   x86 does not reorder loads with other loads, so compiler
+   barriers are enough to keep the copy between the two reads
+   of the sequence number. */
+unsigned
+seqlock_read_begin (const struct seqlock *sl)
+{
+  unsigned seq;
+
+  while ((seq = sl->seq) & 1)
+    {
+      /* Make the compiler load SL->seq afresh each time round. */
+      asm volatile ("pause");
+      barrier ();
+    }
+  barrier ();
+  return seq;
+}
+
+/* Returns true if a write to the data SL protects began after
+   seqlock_read_begin() returned SEQ, in which case the data
+   copied since may be inconsistent and must be copied again. */
+bool
+seqlock_read_retry (const struct seqlock *sl, unsigned seq)
+{
+  barrier ();
+  return sl->seq != seq;
+}
@@ -1,15 +1,17 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 #include <debug.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */             
+    struct heap waiters;        /* Waiting threads, highest priority on top. */
     int priority;               
   };
 
@@ -25,12 +27,12 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
-    struct list_elem elem;      /* For storing locks in threads holding locks list. */
+    struct heap_elem elem;      /* For storing locks in the holder's heap of held locks. */
     int max_priority;           /* Priority of the highest priority thread in the waiters list. */
   };
 
 void lock_init (struct lock *);
-bool compare_lock_priority (const struct list_elem *first, const struct list_elem *second, void *aux UNUSED);
+bool compare_lock_priority (const struct heap_elem *first, const struct heap_elem *second, void *aux UNUSED);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
@@ -39,7 +41,7 @@ bool lock_held_by_current_thread (const struct lock *);
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting semaphore_elems. */
+    struct heap waiters;        /* Waiting semaphore_elems, highest priority on top. */
   };
 
 void cond_init (struct condition *);
@@ -47,6 +49,49 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock.  Any number of readers may hold it at
+   once, or a single writer.  A writer that arrives while readers
+   hold the lock keeps new readers out until it has had its turn,
+   and threads waiting behind a writer donate their priority to
+   it as they would to a lock holder. */
+struct rwlock
+  {
+    struct lock lock;           /* Held by the writer, waiting or not. */
+    struct thread *writer;      /* Writer holding the lock, or null. */
+    unsigned readers;           /* Number of readers holding the lock. */
+    bool writer_waiting;        /* Writer waiting for readers to drain? */
+    struct semaphore drained;   /* Upped by the last reader out. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_write_held_by_current_thread (const struct rwlock *);
+void rwlock_self_test (void);
+
+/* Sequence lock.  Protects a few words of read-mostly data, such
+   as the tick count, that readers may copy without excluding
+   writers or each other: a reader copies the data between
+   seqlock_read_begin() and seqlock_read_retry() and tries again
+   if a write overlapped.  Writers keep interrupts off while they
+   write, which serializes them, so a writer may be an interrupt
+   handler. */
+struct seqlock
+  {
+    volatile unsigned seq;      /* Odd while a write is in progress. */
+    enum intr_level old_level;  /* Interrupt level to restore when a
+                                   write ends. */
+  };
+
+void seqlock_init (struct seqlock *);
+void seqlock_write_begin (struct seqlock *);
+void seqlock_write_end (struct seqlock *);
+unsigned seqlock_read_begin (const struct seqlock *);
+bool seqlock_read_retry (const struct seqlock *, unsigned seq);
+void seqlock_self_test (void);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
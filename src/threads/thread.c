@@ -1,5 +1,7 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <limits.h>
+#include <round.h>
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
@@ -22,9 +24,27 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Number of distinct priority levels, one run queue per level. */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1)
+
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO
+   queue per priority level; bit P of ready_bitmap is set iff
+   ready_queues[P] is non-empty, so the highest ready priority is
+   found with a single bit scan.  Under -cfs the priority queues
+   go unused and ready threads are kept in cfs_queue instead,
+   ordered by vruntime.  Real-time threads with budget left wait
+   in edf_queue, ordered by deadline, and run before any other
+   ready thread; those that have spent their budget wait in
+   edf_throttled for their next period, in the THREAD_READY state
+   but not runnable. */
+static struct list ready_queues[PRI_CNT];
+static uint64_t ready_bitmap;
+static struct rb_tree cfs_queue;
+static int64_t min_vruntime;    /* Monotonic vruntime floor under -cfs. */
+static struct rb_tree edf_queue;
+static struct list edf_throttled;
+static size_t ready_cnt;        /* # of ready threads. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -62,6 +82,69 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 bool thread_mlfqs;
 int load_avg = 0;
 
+/* If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-cfs". */
+bool thread_cfs;
+
+/* Completely fair scheduler.  Each tick that a thread runs adds
+   CFS_TICK * cfs_weights[NICE_DEFAULT] / weight to its vruntime,
+   where weight depends on its nice value, and the ready thread
+   with the least vruntime runs next.  Over time every thread's
+   share of the CPU is therefore proportional to its weight.
+   Each step in nice changes the weight by about 25%, giving a
+   10% change in CPU share between two competing threads.
+
+   A thread that wakes up after sleeping may lag min_vruntime by
+   at most CFS_SLEEPER_CREDIT, so a long sleep does not let it
+   monopolize the CPU afterward, and it preempts the running
+   thread only if it leads by more than CFS_WAKEUP_GRANULARITY. */
+#define CFS_TICK (1 << 16)                     /* vruntime of a tick at nice 0. */
+#define CFS_SLEEPER_CREDIT (TIME_SLICE * CFS_TICK)
+#define CFS_WAKEUP_GRANULARITY CFS_TICK
+static const int cfs_weights[NICE_MAX - NICE_MIN + 1] =
+  {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+    /*  20 */    12,
+  };
+
+/* Earliest-deadline-first real-time class.  Each real-time
+   thread is admitted with a share of the CPU, its budget divided
+   by its period, in units of 1/EDF_UTIL_SCALE.  EDF meets every
+   deadline as long as the shares sum to at most the whole CPU,
+   so edf_util_total may not exceed EDF_UTIL_SCALE. */
+#define EDF_UTIL_SCALE 1000
+static int edf_util_total;
+
+/* Once-per-second recent_cpu decay under -mlfqs.  Each second
+   starts a new decay epoch whose coefficient,
+   (2*load_avg)/(2*load_avg + 1), is remembered here so that a
+   thread that was blocked through several epochs can apply the
+   decays it missed when it is next examined.  Only the last
+   DECAY_HISTORY coefficients are kept, so decay_list holds every
+   thread in order of the last epoch folded into its recent_cpu,
+   and a new epoch first brings up to date the threads that would
+   otherwise miss a coefficient that is about to be overwritten. */
+#define DECAY_HISTORY 256
+static unsigned decay_epoch;
+static int decay_coefficients[DECAY_HISTORY];
+static struct list decay_list;
+
+/* Ready threads are brought up to date lazily, a priority level
+   at a time.  For each level, the least nice value and the
+   earliest decay epoch of any thread queued there since the
+   level was last empty bound how far the decays its threads have
+   missed could raise their priorities.  See
+   ready_queue_max_priority(). */
+static int ready_nice_min[PRI_CNT];
+static unsigned ready_epoch_min[PRI_CNT];
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -73,6 +156,25 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *, int priority);
+static struct thread *ready_queue_pop (void);
+static void ready_queue_requeue (struct thread *, int old_priority);
+static int ready_queue_max_priority (void);
+static int ready_queue_decay_bound (int level);
+static void ready_queue_refresh (int level);
+static void start_decay_epoch (void);
+static bool cfs_less (const struct rb_elem *, const struct rb_elem *,
+                      void *aux);
+static void cfs_place (struct thread *);
+static void cfs_update_min_vruntime (const struct thread *);
+static bool cfs_preempts (const struct thread *, const struct thread *);
+static bool edf_less (const struct rb_elem *, const struct rb_elem *,
+                      void *aux);
+static bool edf_deadline_less (const struct list_elem *,
+                               const struct list_elem *, void *aux);
+static void edf_release (struct thread *cur);
+static bool edf_preempts (const struct thread *, const struct thread *);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -90,11 +192,21 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
+  for (i = 0; i < PRI_CNT; i++)
+    list_init (&ready_queues[i]);
+  ready_bitmap = 0;
+  rb_init (&cfs_queue, cfs_less, NULL);
+  min_vruntime = 0;
+  rb_init (&edf_queue, edf_less, NULL);
+  list_init (&edf_throttled);
+  ready_cnt = 0;
   list_init (&all_list);
+  list_init (&decay_list);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -122,11 +234,11 @@ thread_start (void)
   sema_down (&idle_started);
 }
 
-/* Returns the number of threads currently in the ready list */
+/* Returns the number of threads currently in the ready queues. */
 size_t
 threads_ready (void)
 {
-  return list_size (&ready_list);
+  return ready_cnt;
 }
 
 /* Called by the timer interrupt handler at each timer tick.
@@ -142,26 +254,29 @@ thread_tick (void)
     if(thread_current() != idle_thread)
       thread_current()->recent_cpu = FP_ADD (thread_current ()->recent_cpu, FP (1));
 
-    /* Update recent CPU for all threads every second */
+    /* Decay recent CPU once a second.  Only the running thread is
+       brought up to date now.  Ready threads fold the decay in
+       when ready_queue_max_priority() finds that it could change
+       which of them runs next, and blocked threads when they are
+       unblocked. */
     if (timer_ticks () % TIMER_FREQ == 0) {
       calculate_load_avg ();
-      thread_foreach (calculate_recent_cpu, NULL);
+      start_decay_epoch ();
+      calculate_recent_cpu (t, NULL);
     }
 
-    /* Update priority for all threads every 4 ticks */
-    if (timer_ticks () % 4 == 0 || timer_ticks () % TIMER_FREQ == 0) {
-      calculate_priority (thread_current (), NULL);
-      thread_forin (&calculate_priority, &ready_list, NULL);
+    /* Between decays only the running thread's recent CPU changes,
+       so it is the only priority to recompute every 4 ticks. */
+    if (timer_ticks () % 4 == 0) {
+      calculate_priority (t, NULL);
       
       bool yield = false;
       enum intr_level old_level = intr_disable();
 
-      /* Yield if current thread no longer has highest priority */
-      if (!list_empty (&ready_list)) {
-        struct thread *front = list_entry (list_front (&ready_list), struct thread, elem);
-        if (front->priority > t->priority)
-          yield = true;
-      }
+      /* Yield if current thread no longer has highest priority.
+         Priorities never preempt a real-time thread. */
+      if (t->edf_period == 0 && ready_queue_max_priority () > t->priority)
+        yield = true;
 
       intr_set_level(old_level);
 
@@ -175,6 +290,23 @@ thread_tick (void)
     }
   }
 
+  /* Charge a real-time thread's budget, and have it give up the
+     CPU until its next period once the budget is spent. */
+  if (t->edf_period != 0 && --t->edf_remaining <= 0)
+    intr_yield_on_return ();
+  edf_release (t);
+
+  /* Charge the running thread for this tick under -cfs. */
+  if (thread_cfs && t != idle_thread && t->edf_period == 0)
+    {
+      int nice = t->nice < NICE_MIN ? NICE_MIN
+                 : t->nice > NICE_MAX ? NICE_MAX : t->nice;
+
+      t->vruntime += (int64_t) CFS_TICK * cfs_weights[NICE_DEFAULT - NICE_MIN]
+                     / cfs_weights[nice - NICE_MIN];
+      cfs_update_min_vruntime (t);
+    }
+
   /* Update statistics. */
   if (t == idle_thread)
     idle_ticks++;
@@ -192,6 +324,14 @@ thread_tick (void)
     intr_yield_on_return ();
 }
 
+/* Accounts for CNT timer ticks that passed without a timer
+   interrupt while the idle thread had the tick stopped. */
+void
+thread_skip_ticks (int64_t cnt)
+{
+  idle_ticks += cnt;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) 
@@ -300,6 +440,7 @@ void
 thread_unblock (struct thread *t) 
 {
   enum intr_level old_level;
+  struct thread *cur;
 
   ASSERT (is_thread (t));
 
@@ -309,14 +450,18 @@ thread_unblock (struct thread *t)
   if(thread_mlfqs)
     calculate_priority (t, NULL);
 
-  list_insert_ordered (&ready_list, &t->elem, &compare_priority, NULL);
-
+  if (thread_cfs)
+    cfs_place (t);
+  ready_queue_push (t);
   t->status = THREAD_READY;
 
   intr_set_level (old_level);
 
-  /* Yield current thread if unblocked thread has higher priority. */
-  if (compare_priority (&t->elem, &thread_current ()->elem, NULL)) {
+  /* Yield current thread if unblocked thread should run first. */
+  cur = thread_current ();
+  if (t->edf_period != 0 || cur->edf_period != 0 ? edf_preempts (t, cur)
+      : thread_cfs ? cfs_preempts (t, cur)
+      : compare_priority (&t->elem, &cur->elem, NULL)) {
     if (intr_context ()) {
       intr_yield_on_return ();
     } else {
@@ -374,7 +519,9 @@ thread_exit (void)
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
   intr_disable ();
+  edf_util_total -= thread_current ()->edf_util;
   list_remove (&thread_current()->allelem);
+  list_remove (&thread_current ()->decay_elem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -393,7 +540,7 @@ thread_yield (void)
   old_level = intr_disable ();
   
   if (cur != idle_thread) {
-    list_insert_ordered (&ready_list, &cur->elem, &compare_priority, NULL);
+    ready_queue_push (cur);
     cur->status = THREAD_READY;
     schedule ();
   }
@@ -406,16 +553,21 @@ void
 donate (struct thread *t, int new_priority) {
 
 
-  if(thread_mlfqs)
+  if(thread_mlfqs || thread_cfs)
     return;
 
+  int old_priority = t->priority;
+
   if (new_priority > t->priority)
     t->priority = new_priority;
   
-  /* Resort the list of ready threads after thread's priority has been changed. */
-  if (t->status == THREAD_READY) {
-    list_resort (&ready_list, &(t->elem), &compare_priority);
-  }
+  /* Move a ready thread to the queue for its new priority, and a
+     thread blocked on a semaphore up among its fellow waiters. */
+  if (t->status == THREAD_READY)
+    ready_queue_requeue (t, old_priority);
+  else if (t->status == THREAD_BLOCKED && t->waiting_sema != NULL
+           && t->priority != old_priority)
+    heap_promote (&t->waiting_sema->waiters, &t->wait_elem);
 }
 
 /* Compares priorities of two threads, 
@@ -427,23 +579,23 @@ compare_priority(const struct list_elem *first, const struct list_elem *second,
   return thread_a->priority > thread_b->priority;
 }
 
-/* Add a lock to the thread's currently held locks list. */
+/* Add a lock to the thread's currently held locks. */
 void
 thread_add_lock (struct lock *lock)
 {
   enum intr_level old_level = intr_disable ();
 
-  list_insert_ordered (&thread_current ()->locks, &(lock->elem), &compare_lock_priority, NULL);
+  heap_push (&thread_current ()->locks, &lock->elem);
 
   intr_set_level (old_level);
 }
 
-/* Remove a lock from thread's currently held locks list. */
+/* Remove a lock from thread's currently held locks. */
 void thread_remove_lock (struct lock *lock)
 {
   enum intr_level old_level = intr_disable ();
 
-  list_remove (&(lock->elem));
+  heap_remove (&thread_current ()->locks, &lock->elem);
 
   intr_set_level (old_level);
 
@@ -506,8 +658,8 @@ thread_set_priority (int new_priority)
   }
   
   /* Check for previous donations to revert priority to. */
-  if (!list_empty (&curr->locks)) {
-    int prev_donation = list_entry (list_front (&curr->locks), struct lock, elem)->max_priority;
+  if (!heap_empty (&curr->locks)) {
+    int prev_donation = heap_entry (heap_top (&curr->locks), struct lock, elem)->max_priority;
     if (prev_donation > new_priority)
       curr->priority = prev_donation;
   } 
@@ -523,6 +675,67 @@ thread_set_priority (int new_priority)
   }
 }
 
+/* Moves the current thread into the earliest-deadline-first
+   real-time class.  In every PERIOD ticks, starting now, the
+   thread may run for up to BUDGET ticks.  While it has budget
+   left it preempts every thread outside the class, and among
+   real-time threads the one whose period ends soonest runs
+   first.  Once its budget is spent the thread does not run again
+   until its next period begins.  A PERIOD of 0 returns the
+   thread to the normal scheduling classes.
+
+   Returns false, leaving the thread's class unchanged, if
+   admitting the thread would give real-time threads more than
+   the whole CPU. */
+bool
+thread_set_deadline (int64_t period, int64_t budget)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int util = 0;
+
+  ASSERT (period >= 0);
+  ASSERT (period == 0 || (0 < budget && budget <= period));
+
+  /* Round the share up, so that rounding cannot admit an
+     over-subscribed set of threads. */
+  if (period != 0)
+    util = DIV_ROUND_UP (budget * EDF_UTIL_SCALE, period);
+
+  old_level = intr_disable ();
+  if (edf_util_total - cur->edf_util + util > EDF_UTIL_SCALE)
+    {
+      intr_set_level (old_level);
+      return false;
+    }
+  edf_util_total += util - cur->edf_util;
+  cur->edf_util = util;
+  cur->edf_period = period;
+  cur->edf_budget = budget;
+  cur->edf_deadline = timer_ticks () + period;
+  cur->edf_remaining = budget;
+  intr_set_level (old_level);
+
+  /* A thread that left the class may now be outranked. */
+  if (test_yield ())
+    thread_yield ();
+  return true;
+}
+
+/* Returns the tick at which the earliest throttled real-time
+   thread gets its next budget, or INT64_MAX if none is waiting
+   for one.  Must be called with interrupts off. */
+int64_t
+thread_edf_next_release (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (list_empty (&edf_throttled))
+    return INT64_MAX;
+  return list_entry (list_front (&edf_throttled), struct thread,
+                     elem)->edf_deadline;
+}
+
 /* Returns the current thread's priority. */
 int
 thread_get_priority (void) 
@@ -535,7 +748,7 @@ void
 revoke_donation () 
 {
   struct thread *cur = thread_current ();
-  if(thread_mlfqs)
+  if(thread_mlfqs || thread_cfs)
     return;
   if (cur->priority == cur->base_priority)
     return;
@@ -545,10 +758,11 @@ revoke_donation ()
   enum intr_level old_level = intr_disable ();
 
   /* Check for previous donations to revert to. */
-  if (!list_empty (&cur->locks)) {
-    new_priority = list_entry (list_front (&cur->locks), struct lock, elem)->max_priority;
-  } else {
-    new_priority = cur->base_priority;
+  new_priority = cur->base_priority;
+  if (!heap_empty (&cur->locks)) {
+    int prev_donation = heap_entry (heap_top (&cur->locks), struct lock, elem)->max_priority;
+    if (prev_donation > new_priority)
+      new_priority = prev_donation;
   }
 
   /* Change thread's effective priority to previous donation or base priority). */
@@ -556,9 +770,6 @@ revoke_donation ()
 
   intr_set_level (old_level);
 
-  /* Resort ready list. */
-  if (cur->status == THREAD_READY)
-    list_resort (&ready_list, &(cur->elem), &compare_priority);
   if (cur->status == THREAD_RUNNING) {
     /* Check if thread should yield the CPU. */
     if (test_yield ())
@@ -573,13 +784,16 @@ test_yield (void) {
 
   bool yield = false;
   
-  /* Check if thread needs to yield to the highest priority ready thread. */
-  if (!list_empty(&ready_list)) {
-    struct thread *thread_front = list_entry (list_front(&ready_list), struct thread, elem);
-    if (thread_get_priority () < thread_front->priority) {
-      yield = true;
-    }
-  }
+  /* Check if thread needs to yield to a ready real-time thread, or
+     to the highest priority ready thread.  Priorities do not order
+     the run queue under -cfs, and never preempt a real-time
+     thread. */
+  if (thread_current ()->edf_period != 0)
+    yield = false;
+  else if (!rb_empty (&edf_queue))
+    yield = true;
+  else if (!thread_cfs && thread_get_priority () < ready_queue_max_priority ())
+    yield = true;
 
   intr_set_level (old_level);
 
@@ -612,7 +826,30 @@ void calculate_load_avg () {
               ); 
 }
 
-void calculate_recent_cpu (struct thread *t, void *aux UNUSED) {
+/* Starts a new decay epoch using the current load_avg.  Must be
+   called with interrupts off. */
+static void
+start_decay_epoch (void) {
+  /* Catch up the threads that still need the coefficient about to
+     be overwritten.  Each thread is caught up at most once every
+     DECAY_HISTORY epochs.  A ready thread's priority and queue
+     are brought up to date with it, since the bound that
+     ready_queue_decay_bound() puts on its priority assumes they
+     match its recent CPU. */
+  while (!list_empty (&decay_list)) {
+    struct thread *t = list_entry (list_front (&decay_list),
+                                   struct thread, decay_elem);
+    if (decay_epoch - t->recent_cpu_epoch < DECAY_HISTORY)
+      break;
+    if (t->status == THREAD_READY) {
+      int old_priority = t->priority;
+      calculate_priority (t, NULL);
+      ready_queue_requeue (t, old_priority);
+    } else {
+      calculate_recent_cpu (t, NULL);
+    }
+  }
+
   int coefficient = FP_DIV (
                       FP_MUL (
                         FP (2),
@@ -623,16 +860,36 @@ void calculate_recent_cpu (struct thread *t, void *aux UNUSED) {
                           load_avg),
                         FP (1)
                         ));
-  t->recent_cpu = FP_ADD (
-                    FP_MUL(
-                      coefficient,
-                      t->recent_cpu), 
-                    FP (t->nice));
+  decay_epoch++;
+  decay_coefficients[decay_epoch % DECAY_HISTORY] = coefficient;
+}
+
+/* Applies every decay of T's recent CPU that T has missed since
+   it was last brought up to date.  Must be called with interrupts
+   off. */
+void calculate_recent_cpu (struct thread *t, void *aux UNUSED) {
+  unsigned missed = decay_epoch - t->recent_cpu_epoch;
 
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (missed <= DECAY_HISTORY);
+
+  for (; missed > 0; missed--) {
+    int coefficient = decay_coefficients[(decay_epoch - missed + 1) % DECAY_HISTORY];
+    t->recent_cpu = FP_ADD (
+                      FP_MUL(
+                        coefficient,
+                        t->recent_cpu), 
+                      FP (t->nice));
+  }
+  t->recent_cpu_epoch = decay_epoch;
+  list_remove (&t->decay_elem);
+  list_push_back (&decay_list, &t->decay_elem);
 }
 
 void calculate_priority (struct thread *t, void *aux UNUSED) {
   int priority = PRI_MIN;
+
+  calculate_recent_cpu (t, NULL);
   if(t != idle_thread){
     priority = FP_FLOOR (
                   FP_SUB (
@@ -712,6 +969,17 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Nothing is ready: zero free pages for later allocations
+         until there are none left or another thread is ready. */
+      while (threads_ready () == 0 && palloc_zero_free_page ())
+        continue;
+      if (threads_ready () != 0)
+        continue;
+
+      /* Still nothing is ready: in tickless mode, let the timer skip the
+         ticks on which nothing is due. */
+      timer_idle_enter ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -725,6 +993,9 @@ idle (void *idle_started_ UNUSED)
          See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
          7.11.1 "HLT Instruction". */
       asm volatile ("sti; hlt" : : : "memory");
+
+      intr_disable ();
+      timer_idle_exit ();
     }
 }
 
@@ -781,6 +1052,8 @@ init_thread (struct thread *t, const char *name, int priority)
   t->nice = running_thread()->nice;
   t->recent_cpu = 0;
   t->recent_cpu = running_thread()->recent_cpu;
+  t->recent_cpu_epoch = decay_epoch;
+  t->vruntime = min_vruntime;
   t->parent = NULL;
 
   t->waited = false;
@@ -799,11 +1072,12 @@ init_thread (struct thread *t, const char *name, int priority)
   t->page_table = NULL;
 #endif
   
-  list_init(&(t->locks));
+  heap_init (&t->locks, compare_lock_priority, NULL);
   t->magic = THREAD_MAGIC;
 
   old_level = intr_disable ();
 
+  list_push_back (&decay_list, &t->decay_elem);
   if (thread_mlfqs)
     calculate_priority(t, NULL);
   
@@ -832,11 +1106,364 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list)) {
-    return idle_thread;
-  } else {
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
-  }
+  struct thread *t = ready_queue_pop ();
+
+  return t != NULL ? t : idle_thread;
+}
+
+/* Appends T to the back of the ready queue for its priority, or
+   under -cfs inserts it after the threads with no greater
+   vruntime.  A real-time thread instead starts a new period if
+   its current one is over, and then goes on the real-time run
+   queue if it has budget left, or waits for its next period if
+   not.  Must be called with interrupts off. */
+static void
+ready_queue_push (struct thread *t)
+{
+  int level = t->priority - PRI_MIN;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+  if (t->edf_period != 0)
+    {
+      int64_t now = timer_ticks ();
+
+      if (now >= t->edf_deadline)
+        {
+          t->edf_deadline = now + t->edf_period;
+          t->edf_remaining = t->edf_budget;
+        }
+      if (t->edf_remaining > 0)
+        {
+          rb_insert (&edf_queue, &t->edf_elem);
+          ready_cnt++;
+        }
+      else
+        list_insert_ordered (&edf_throttled, &t->elem,
+                             edf_deadline_less, NULL);
+      return;
+    }
+
+  if (thread_cfs)
+    {
+      rb_insert (&cfs_queue, &t->cfs_elem);
+      ready_cnt++;
+      return;
+    }
+
+  if (list_empty (&ready_queues[level])
+      || t->nice < ready_nice_min[level])
+    ready_nice_min[level] = t->nice;
+  if (list_empty (&ready_queues[level])
+      || decay_epoch - t->recent_cpu_epoch
+         > decay_epoch - ready_epoch_min[level])
+    ready_epoch_min[level] = t->recent_cpu_epoch;
+
+  list_push_back (&ready_queues[level], &t->elem);
+  ready_bitmap |= (uint64_t) 1 << level;
+  ready_cnt++;
+}
+
+/* Removes T from the ready queue for PRIORITY, the priority it
+   was queued at.  Must be called with interrupts off. */
+static void
+ready_queue_remove (struct thread *t, int priority)
+{
+  int level = priority - PRI_MIN;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->edf_period != 0)
+    {
+      rb_remove (&edf_queue, &t->edf_elem);
+      ready_cnt--;
+      return;
+    }
+
+  if (thread_cfs)
+    {
+      rb_remove (&cfs_queue, &t->cfs_elem);
+      ready_cnt--;
+      return;
+    }
+
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[level]))
+    ready_bitmap &= ~((uint64_t) 1 << level);
+  ready_cnt--;
+}
+
+/* Removes and returns the real-time thread with the earliest
+   deadline, if any, or else the thread at the front of the
+   highest priority non-empty ready queue, or under -cfs the
+   thread with the least vruntime, or a null pointer if no thread
+   is ready.  Must be called with interrupts off. */
+static struct thread *
+ready_queue_pop (void)
+{
+  int priority = ready_queue_max_priority ();
+  struct thread *t;
+
+  if (!rb_empty (&edf_queue))
+    {
+      t = rb_entry (rb_min (&edf_queue), struct thread, edf_elem);
+      ready_queue_remove (t, t->priority);
+      return t;
+    }
+
+  if (thread_cfs)
+    {
+      struct rb_elem *e = rb_min (&cfs_queue);
+      if (e == NULL)
+        return NULL;
+      t = rb_entry (e, struct thread, cfs_elem);
+      ready_queue_remove (t, t->priority);
+      return t;
+    }
+
+  if (priority < PRI_MIN)
+    return NULL;
+
+  t = list_entry (list_front (&ready_queues[priority - PRI_MIN]),
+                  struct thread, elem);
+  ready_queue_remove (t, priority);
+  return t;
+}
+
+/* Moves ready thread T, queued at OLD_PRIORITY, to the back of
+   the queue for its current priority.  Priorities do not order
+   the run queue under -cfs or for real-time threads, so then T
+   stays where it is. */
+static void
+ready_queue_requeue (struct thread *t, int old_priority)
+{
+  enum intr_level old_level;
+
+  if (thread_cfs || t->edf_period != 0 || t->priority == old_priority)
+    return;
+
+  old_level = intr_disable ();
+  ready_queue_remove (t, old_priority);
+  ready_queue_push (t);
+  intr_set_level (old_level);
+}
+
+/* Returns the highest priority with a non-empty ready queue, or
+   PRI_MIN - 1 if every queue is empty.
+
+   Under -mlfqs, ready threads are not decayed when a decay epoch
+   starts, so a queue may hold threads whose priorities are out
+   of date.  The top queue is brought up to date here first, and
+   then any lower queue whose threads could, by
+   ready_queue_decay_bound(), have risen to its level or above,
+   until the top queue is current and no lower queue could
+   overtake it.  Each ready thread is thus recomputed at most
+   once per epoch, and only if it might run next.  Must be called
+   with interrupts off. */
+static int
+ready_queue_max_priority (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (;;)
+    {
+      uint32_t high = ready_bitmap >> 32;
+      uint32_t low = ready_bitmap;
+      int priority;
+      int level;
+
+      if (high != 0)
+        priority = PRI_MIN + 63 - __builtin_clz (high);
+      else if (low != 0)
+        priority = PRI_MIN + 31 - __builtin_clz (low);
+      else
+        return PRI_MIN - 1;
+
+      if (!thread_mlfqs)
+        return priority;
+      if (ready_epoch_min[priority - PRI_MIN] != decay_epoch)
+        {
+          ready_queue_refresh (priority - PRI_MIN);
+          continue;
+        }
+
+      for (level = priority - PRI_MIN - 1; level >= 0; level--)
+        if ((ready_bitmap & ((uint64_t) 1 << level)) != 0
+            && ready_epoch_min[level] != decay_epoch
+            && FP_FLOOR (ready_queue_decay_bound (level)) >= priority)
+          break;
+      if (level < 0)
+        return priority;
+      ready_queue_refresh (level);
+    }
+}
+
+/* Returns, in fixed point, an upper bound on the priority of any
+   thread queued at LEVEL once it has folded in the decays it has
+   missed.  A thread's priority before a decay is less than
+   LEVEL + 1, which bounds its recent CPU from below, and after
+   the decay its priority is greatest if its nice value is the
+   least one queued at LEVEL.  Applying each missed decay to the
+   greater of the bound so far and LEVEL + 1 covers threads that
+   have missed any number of them.  Must be called with
+   interrupts off. */
+static int
+ready_queue_decay_bound (int level)
+{
+  unsigned missed = decay_epoch - ready_epoch_min[level];
+  int nice = ready_nice_min[level];
+  int start = FP (PRI_MIN + level + 1);
+  int bound = start;
+
+  if (missed > DECAY_HISTORY)
+    missed = DECAY_HISTORY;
+  for (; missed > 0; missed--)
+    {
+      int coefficient = decay_coefficients[(decay_epoch - missed + 1) % DECAY_HISTORY];
+      int priority = bound > start ? bound : start;
+      int recent_cpu = FP_SUB (FP (PRI_MAX - 2 * nice), priority);
+
+      recent_cpu *= 4;
+      recent_cpu = FP_ADD (FP_MUL (coefficient, recent_cpu), FP (nice));
+      bound = FP_SUB (FP_SUB (FP (PRI_MAX), recent_cpu / 4), FP (2 * nice));
+    }
+  return bound;
+}
+
+/* Brings every thread queued at LEVEL up to date with the decays
+   it has missed, and moves each one whose priority changes to the
+   queue for its new priority.  Must be called with interrupts
+   off. */
+static void
+ready_queue_refresh (int level)
+{
+  struct list *queue = &ready_queues[level];
+  struct list_elem *e = list_begin (queue);
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (e != list_end (queue))
+    {
+      struct thread *t = list_entry (e, struct thread, elem);
+      e = list_next (e);
+      calculate_priority (t, NULL);
+      if (t->priority != PRI_MIN + level)
+        {
+          ready_queue_remove (t, PRI_MIN + level);
+          ready_queue_push (t);
+        }
+    }
+  ready_epoch_min[level] = decay_epoch;
+}
+
+/* Returns true if thread A has less vruntime than thread B. */
+static bool
+cfs_less (const struct rb_elem *a_, const struct rb_elem *b_,
+          void *aux UNUSED)
+{
+  const struct thread *a = rb_entry (a_, struct thread, cfs_elem);
+  const struct thread *b = rb_entry (b_, struct thread, cfs_elem);
+
+  return a->vruntime < b->vruntime;
+}
+
+/* Limits how far waking thread T's vruntime may lag behind
+   min_vruntime.  Must be called with interrupts off. */
+static void
+cfs_place (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->vruntime < min_vruntime - CFS_SLEEPER_CREDIT)
+    t->vruntime = min_vruntime - CFS_SLEEPER_CREDIT;
+}
+
+/* Advances min_vruntime to the least vruntime among the running
+   thread CUR and the ready threads, unless that would move it
+   backward.  Must be called with interrupts off. */
+static void
+cfs_update_min_vruntime (const struct thread *cur)
+{
+  struct rb_elem *e = rb_min (&cfs_queue);
+  int64_t vruntime = cur->vruntime;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (e != NULL && rb_entry (e, struct thread, cfs_elem)->vruntime < vruntime)
+    vruntime = rb_entry (e, struct thread, cfs_elem)->vruntime;
+  if (vruntime > min_vruntime)
+    min_vruntime = vruntime;
+}
+
+/* Returns true if newly ready thread T should preempt running
+   thread CUR under -cfs. */
+static bool
+cfs_preempts (const struct thread *t, const struct thread *cur)
+{
+  return cur == idle_thread
+         || t->vruntime + CFS_WAKEUP_GRANULARITY < cur->vruntime;
+}
+
+/* Returns true if real-time thread A's deadline is earlier than
+   real-time thread B's. */
+static bool
+edf_less (const struct rb_elem *a_, const struct rb_elem *b_,
+          void *aux UNUSED)
+{
+  const struct thread *a = rb_entry (a_, struct thread, edf_elem);
+  const struct thread *b = rb_entry (b_, struct thread, edf_elem);
+
+  return a->edf_deadline < b->edf_deadline;
+}
+
+/* Returns true if throttled thread A's next period begins before
+   throttled thread B's. */
+static bool
+edf_deadline_less (const struct list_elem *a_, const struct list_elem *b_,
+                   void *aux UNUSED)
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->edf_deadline < b->edf_deadline;
+}
+
+/* Returns the throttled real-time threads whose next period has
+   begun to the run queue, and arranges for running thread CUR to
+   be preempted if one of them should run first.  Must be called
+   from the timer interrupt. */
+static void
+edf_release (struct thread *cur)
+{
+  int64_t now = timer_ticks ();
+
+  ASSERT (intr_context ());
+
+  while (!list_empty (&edf_throttled))
+    {
+      struct thread *t = list_entry (list_front (&edf_throttled),
+                                     struct thread, elem);
+      if (t->edf_deadline > now)
+        break;
+      list_pop_front (&edf_throttled);
+      ready_queue_push (t);
+      if (edf_preempts (t, cur))
+        intr_yield_on_return ();
+    }
+}
+
+/* Returns true if newly ready thread T should preempt running
+   thread CUR, one of which is a real-time thread.  A real-time
+   thread with budget left preempts any other thread except a
+   real-time thread with an earlier or equal deadline. */
+static bool
+edf_preempts (const struct thread *t, const struct thread *cur)
+{
+  if (t->edf_period == 0 || t->edf_remaining <= 0)
+    return false;
+  return (cur == idle_thread || cur->edf_period == 0
+          || t->edf_deadline < cur->edf_deadline);
 }
 
 /* Completes a thread switch by activating the new thread's page
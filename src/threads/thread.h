@@ -3,6 +3,7 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "synch.h"
@@ -26,6 +27,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness. */
+#define NICE_MIN -20                    /* Highest claim on the CPU. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Lowest claim on the CPU. */
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -76,12 +82,14 @@ typedef int tid_t;
    the `magic' member of the running thread's `struct thread' is
    set to THREAD_MAGIC.  Stack overflow will normally change this
    value, triggering the assertion. */
-/* The `elem' member has a dual purpose.  It can be an element in
-   the run queue (thread.c), or it can be an element in a
-   semaphore wait list (synch.c).  It can be used these two ways
-   only because they are mutually exclusive: only a thread in the
-   ready state is on the run queue, whereas only a thread in the
-   blocked state is on a semaphore wait list. */
+/* The `elem' member has a double purpose.  It can be an element
+   in the run queue (thread.c) or an element in a timer wheel slot
+   while the thread sleeps in timer_sleep() (timer.c).  It can be
+   used these ways only because they are mutually exclusive: only
+   a thread in the ready state is on the run queue, whereas only a
+   blocked thread sleeps on the timer.  A thread blocked on a
+   semaphore is instead in the semaphore's waiters heap through
+   its `wait_elem' member (synch.c). */
 struct thread
   {
     /* Owned by thread.c. */
@@ -93,13 +101,33 @@ struct thread
     int base_priority;                 /* Base Priority */
     int nice;                          /* Nice value for advanced scheduler */
     int recent_cpu;
+    unsigned recent_cpu_epoch;         /* Last decay epoch folded into recent_cpu. */
+    struct list_elem decay_elem;       /* List element for decay list. */
+    int64_t vruntime;                  /* Weighted CPU time under -cfs. */
     struct list_elem allelem;          /* List element for all threads list. */
 
     struct lock *waiting_on;           /* The lock currently blocking the thread. */
-    struct list locks;                 /* List of locks the thread is currently holding. */
+    struct heap locks;                 /* Locks the thread holds, highest max_priority on top. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;             /* List element. */ 
+    struct heap_elem wait_elem;        /* Element in a semaphore's waiters. */
+    struct semaphore *waiting_sema;    /* Semaphore the thread is blocked on, if any. */
+    unsigned read_locks;               /* Number of rwlocks held for reading. */
+
+    struct rb_elem cfs_elem;           /* Run queue element under -cfs. */
+
+    /* Earliest-deadline-first real-time class, see
+       thread_set_deadline().  Owned by thread.c. */
+    int64_t edf_period;                /* Period in ticks, 0 if not real-time. */
+    int64_t edf_budget;                /* Ticks of CPU time per period. */
+    int64_t edf_deadline;              /* End of the current period. */
+    int64_t edf_remaining;             /* Budget left in the current period. */
+    int edf_util;                      /* Admitted share of the CPU. */
+    struct rb_elem edf_elem;           /* EDF run queue element. */
+
+    /* Shared between thread.c and timer.c. */
+    int64_t wake_up_time;              /* Tick to wake up at while in timer_sleep(). */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -121,6 +149,7 @@ struct thread
 #endif
 
 	struct hash *page_table;                    /* Thread's supplemental page table. */
+	struct rb_tree vmas;                        /* Areas of the address space. */
    uint8_t *esp;
    
     /* Owned by thread.c. */
@@ -132,6 +161,11 @@ struct thread
    Controlled by kernel command-line option "mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler, which runs the
+   ready thread with the least weighted CPU time.
+   Controlled by kernel command-line option "cfs". */
+extern bool thread_cfs;
+
 extern int load_avg;
 
 void calculate_priority(struct thread*, void *aux UNUSED);
@@ -143,6 +177,7 @@ void thread_start (void);
 size_t threads_ready(void);
 
 void thread_tick (void);
+void thread_skip_ticks (int64_t cnt);
 void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
@@ -178,6 +213,8 @@ bool test_yield (void);
 void list_resort (struct list *list, struct list_elem *elem, list_less_func *less);
 int thread_get_priority (void);
 void thread_set_priority (int);
+bool thread_set_deadline (int64_t period, int64_t budget);
+int64_t thread_edf_next_release (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
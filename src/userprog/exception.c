@@ -164,10 +164,11 @@ page_fault (struct intr_frame *f)
             user ? "user" : "kernel");
 */
    if (not_present) {
-    struct page *p = page_lookup (curr->page_table, fault_addr);
+    struct page *p = page_from_vma (curr->page_table, &curr->vmas,
+                                    fault_addr);
 
     if (p != NULL) {
-      if (!load_page (curr->page_table, curr->pagedir, p)) {
+      if (!load_page (curr->page_table, curr->pagedir, p, write)) {
             goto PAGE_FAULT_VIOLATED_ACCESS;
       }
       return;
@@ -180,6 +181,20 @@ page_fault (struct intr_frame *f)
       }
       return;
     }
+  } else if (write && curr->page_table != NULL) {
+    /* Writing a page shared copy-on-write since fork(), or a
+       zero page mapped to the shared zero frame. */
+    struct page *p = page_lookup (curr->page_table, fault_addr);
+
+    if (p != NULL && p->writable) {
+      bool copied = p->status == ALL_ZERO
+                    ? load_page (curr->page_table, curr->pagedir, p, true)
+                    : frame_copy_on_write (p);
+      if (!copied) {
+        goto PAGE_FAULT_VIOLATED_ACCESS;
+      }
+      return;
+    }
   }
 
   if ((int*) fault_addr != 0xffffffff && !user) {
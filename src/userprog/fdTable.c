@@ -165,3 +165,51 @@ void close_files(int tid){
     table = table->nextTable;
   }
 }
+
+/* Gives the current thread a copy of each file that thread TID
+   has open, under the same file descriptor, for fork().  Returns
+   false if memory runs out, leaving the copies made so far for
+   close_files() to close. */
+bool copy_files(int tid){
+  struct fdTable *copy = NULL;
+  for(struct fdTable *table = tid_file_table(tid);(table != NULL);table = table->nextTable){
+    struct fdTable *next;
+    if(copy == NULL){
+      next = new_file_table(thread_current()->tid);
+      if(next != NULL){
+        list_push_back(&file_list,&(next->elem));
+      }
+    }else{
+      next = extend_fd_table(copy);
+    }
+    if(next == NULL){
+      return false;
+    }
+    copy = next;
+    for(int i = 0; i < FD_SIZE; i++){
+      if(table->table[i] != NULL){
+        copy->table[i] = file_duplicate(table->table[i]);
+        if(copy->table[i] == NULL){
+          return false;
+        }
+        copy->free -= 1;
+      }
+    }
+  }
+  return true;
+}
+
+/* Returns the file descriptor under which thread TID has FILE
+   open, or -1 if it does not. */
+int file_to_fd(int tid, struct file *file){
+  int fd = 2;
+  for(struct fdTable *table = tid_file_table(tid);(table != NULL);table = table->nextTable){
+    for(int i = 0; i < FD_SIZE; i++){
+      if(table->table[i] == file){
+        return fd + i;
+      }
+    }
+    fd += FD_SIZE;
+  }
+  return -1;
+}
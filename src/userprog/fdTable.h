@@ -18,5 +18,7 @@ struct file* fd_to_file(int);
 int assign_fd (struct file *);
 void remove_fd (int);
 void close_files (int);
+bool copy_files (int);
+int file_to_fd (int, struct file *);
 
 #endif /* userprog/fdTable.h */
\ No newline at end of file
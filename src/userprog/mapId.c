@@ -176,8 +176,8 @@ void close_mapId(int tid){
   for(struct mmapTable *table = proc->mmapTable;(table != NULL);){
     for(int i = 0; i < MM_SIZE && table->free < MM_SIZE ;i++){
       if (table->table[i] != NULL){
-        struct page *page = page_lookup (thread_current ()->page_table, mapId_to_file(i + a));
-        file = page->file;
+        struct vma *vma = vma_find (&thread_current ()->vmas, mapId_to_file(i + a));
+        file = vma->file;
         unmmap(i+a);
         file_close(file);
 
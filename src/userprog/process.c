@@ -23,6 +23,12 @@
 #include "userprog/fdTable.h"
 #include "userprog/mapId.h"
 
+/* A fault on a page of a file maps in the pages of the same area
+   in the aligned window of this many pages around it, so that
+   scanning a file takes one fault per window rather than per
+   page.  1 maps only the page faulted on. */
+unsigned fault_around_pages = 16;
+
 /* Passed argument struct */
 struct arguments {
   char *fn_copy;
@@ -31,8 +37,15 @@ struct arguments {
 };
 
 static thread_func start_process NO_RETURN;
+static thread_func start_fork NO_RETURN;
+static bool fork_address_space (struct thread *parent);
+static bool fork_page (struct page *p);
+static bool install_page (void *upage, void *kpage, bool writable);
 static bool load (const struct arguments *args, void (**eip) (void), void **esp);
 static void *push_args_on_stack (const struct arguments *args);
+static void fault_around (struct hash *pt, struct page *p);
+static void swap_readahead (struct hash *pt, uint32_t *pagedir, uint8_t *upage,
+                            size_t slot);
 
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
@@ -135,6 +148,184 @@ start_process (void *aux)
   NOT_REACHED ();
 }
 
+/* Starts a new process that is a copy of the current one, which
+   made a fork system call with interrupt frame F.  The child
+   returns from the call with 0 while the parent gets the child's
+   thread id, or TID_ERROR if it could not be created.
+
+   The child does not get copies of its parent's memory pages,
+   just their entries in the supplemental page table: pages that
+   are in a frame are mapped read-only and shared by both
+   processes until either writes to them, as page_fault() sees,
+   so the cost of forking is in the pages that are actually
+   written.  The child also gets its own copy of each open file,
+   but not the parent's memory mappings. */
+tid_t
+process_fork (struct intr_frame *f)
+{
+  struct thread *cur = thread_current ();
+  tid_t tid;
+
+  tid = thread_create (cur->name, PRI_DEFAULT, start_fork, f);
+  if (tid == TID_ERROR) {
+    return TID_ERROR;
+  }
+
+  /* Block parent until the child has copied its address space,
+     which must not change in the meantime. */
+  sema_down (&cur->sema_load);
+  if (!cur->load_status) {
+    return TID_ERROR;
+  }
+
+  return tid;
+}
+
+/* A thread function that copies its parent's address space and
+   returns from the parent's fork system call, whose interrupt
+   frame is AUX. */
+static void
+start_fork (void *aux)
+{
+  struct intr_frame if_ = *(struct intr_frame *) aux;
+  struct thread *curr = thread_current ();
+  bool success;
+
+  success = fork_address_space (curr->parent);
+  curr->parent->load_status = success;
+
+  if (!success) {
+    curr->exit_status = -1;
+    sema_up (&curr->parent->sema_load);
+    exit_with_code (-1);
+  } else {
+    sema_up (&curr->parent->sema_load);
+  }
+
+  /* Return 0 from fork() in the child. */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Gives the current thread a page directory, page table, areas
+   and files that are copies of those of PARENT, which is blocked
+   in fork().  Returns true if successful, false otherwise. */
+static bool
+fork_address_space (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct hash_iterator i;
+  struct rb_elem *e;
+  bool success;
+
+  vma_init (&t->vmas);
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL) {
+    return false;
+  }
+  process_activate ();
+
+  t->page_table = malloc (sizeof (struct hash));
+  if (t->page_table == NULL) {
+    return false;
+  }
+  hash_init (t->page_table, page_hash, page_less, NULL);
+
+  rwlock_acquire_write (&filesys_lock);
+  success = copy_files (parent->tid);
+  rwlock_release_write (&filesys_lock);
+  if (!success) {
+    return false;
+  }
+
+  /* Executable segments are mapped from the child's copy of the
+     same file.  Memory mappings are not inherited. */
+  for (e = rb_min (&parent->vmas); e != NULL; e = rb_next (e)) {
+    struct vma *v = rb_entry (e, struct vma, elem);
+    if (v->kind == VMA_MMAP) {
+      continue;
+    }
+
+    int fd = file_to_fd (parent->tid, v->file);
+    if (fd == -1 || vma_create (&t->vmas, v->start, v->end - v->start,
+                                v->kind, fd_to_file (fd), v->offset,
+                                v->read_bytes, v->writable) == NULL) {
+      return false;
+    }
+  }
+
+  hash_first (&i, parent->page_table);
+  while (hash_next (&i)) {
+    if (!fork_page (hash_entry (hash_cur (&i), struct page, hash_elem))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Adds a copy of the parent's page P to the current process.  A page
+   in a frame shares it copy-on-write; one not yet loaded is
+   loaded by the child in its turn, from the child's copy of the
+   same area; one that is swapped out is read into a frame of the
+   child's own.  Pages of memory mappings are not copied.
+   Returns false if memory runs out. */
+static bool
+fork_page (struct page *p)
+{
+  struct vma *vma = NULL;
+  struct page *c;
+
+  if (p->vma != NULL) {
+    if (p->vma->kind == VMA_MMAP) {
+      return true;
+    }
+    vma = vma_find (&thread_current ()->vmas, p->addr);
+    ASSERT (vma != NULL);
+  }
+
+  c = page_copy (thread_current ()->page_table, p, vma);
+  if (c == NULL) {
+    return false;
+  }
+
+  /* Eviction can move P from its frame to swap at any time, but
+     nothing brings it back while the parent waits in fork(). */
+  if (!frame_share (p, c)) {
+    return false;
+  }
+  if (c->kpage != NULL) {
+    return true;
+  }
+  if (p->status != SWAPPED) {
+    /* P was never in a frame, or was in the shared page cache,
+       and is read from its file again when first needed. */
+    c->status = p->status;
+    return true;
+  }
+
+  void *kpage = frame_alloc (PAL_USER, c->addr);
+  if (kpage == NULL) {
+    return false;
+  }
+  frame_set_pinned (kpage, true);
+  if (!install_page (c->addr, kpage, c->writable)) {
+    frame_free (kpage, true);
+    return false;
+  }
+  if (p->zswap != NULL) {
+    zswap_copy (p->zswap, kpage);
+  } else {
+    swap_read (p->swap_slot, kpage);
+  }
+  add_to_pages (kpage, c);
+  c->kpage = kpage;
+  c->status = IN_FRAME;
+  frame_set_pinned (kpage, false);
+
+  return true;
+}
+
 /* Waits for thread TID to die and returns its exit status. 
  * If it was terminated by the kernel (i.e. killed due to an exception), 
  * returns -1.  
@@ -191,10 +382,24 @@ process_exit (void)
   struct thread *cur = thread_current ();
   uint32_t *pd;
 
-  lock_acquire(&filesys_lock);
-  close_files(thread_current()->tid);
+  rwlock_acquire_write (&filesys_lock);
   close_mapId(thread_current()->tid);
-  lock_release(&filesys_lock);
+  rwlock_release_write (&filesys_lock);
+
+  /* Destroy the page hash table, releasing the frames the
+     process's pages are in, unless another process shares them.
+     This must come before the process's files are closed, since
+     the shared page cache identifies frames by their files'
+     inodes. */
+  if (cur->page_table != NULL) {
+    page_table_destroy ();
+    cur->page_table = NULL;
+    vma_destroy_all (&cur->vmas);
+  }
+
+  rwlock_acquire_write (&filesys_lock);
+  close_files(thread_current()->tid);
+  rwlock_release_write (&filesys_lock);
 
   /* Once process exits, stop all children threads waiting blocked on sema_exit. */
   struct list_elem *elem;
@@ -223,10 +428,6 @@ process_exit (void)
       pagedir_destroy (pd);
     }
 
-  /* Destroy the page hash table. */
-  page_table_destroy ();
-  cur->page_table = NULL;
-  
   sema_up (&cur->sema_wait);
 
   /* Wait for parent to remove child from its list of child threads before terminating. */
@@ -332,6 +533,7 @@ load (const struct arguments *args, void (**eip) (void), void **esp)
   bool success = false;
   int i;
   
+  vma_init (&t->vmas);
   if (args->argc == 0) {
     goto done;
   }
@@ -351,7 +553,7 @@ load (const struct arguments *args, void (**eip) (void), void **esp)
   hash_init (t->page_table, page_hash, page_less, NULL);
 
   /* Open executable file. */
-  lock_acquire(&filesys_lock);
+  rwlock_acquire_write (&filesys_lock);
   file = filesys_open (file_name);
 
   if (file == NULL) 
@@ -451,13 +653,13 @@ load (const struct arguments *args, void (**eip) (void), void **esp)
   success = true;
 
  done:
-  lock_release(&filesys_lock);
+  rwlock_release_write (&filesys_lock);
   /* We arrive here whether the load is successful or not. */
   if (!success) {
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write (&filesys_lock);
     file_close (file);
     remove_fd (fd);
-    lock_release(&filesys_lock);
+    rwlock_release_write (&filesys_lock);
   }
 
   return success;
@@ -465,7 +667,6 @@ load (const struct arguments *args, void (**eip) (void), void **esp)
 
 /* load() helpers. */
 
-static bool install_page (void *upage, void *kpage, bool writable);
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -524,37 +725,55 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   Nothing is read yet: the segment becomes an area of the
+   process's address space, whose pages are loaded as the process
+   faults them in.
+
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. */
+   occurs or the segment overlaps another one. */
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
 {
+  struct rb_tree *vmas = &thread_current ()->vmas;
+  struct vma *prev;
+
   ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
-  /* Note: filesys_lock should already be acquired here */
-  file_seek (file, ofs);
-  while (read_bytes > 0 || zero_bytes > 0) 
+  /* Consecutive segments may share the page at their boundary.
+     That page stays in the earlier segment's area, which reads
+     as much of it as either segment needs.  Only a one-page
+     area can become writable this way. */
+  prev = vma_find (vmas, upage);
+  if (prev != NULL)
     {
-      /* Calculate how to fill this page.
-         We will read PAGE_READ_BYTES bytes from FILE
-         and zero the final PAGE_ZERO_BYTES bytes. */
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+      uint32_t prev_ofs = upage - prev->start;
+
+      if (prev->end != upage + PGSIZE || prev->file != file
+          || (page_read_bytes > 0 && prev->offset + (off_t) prev_ofs != ofs))
+        return false;
+      if (writable && !prev->writable)
+        {
+          if (prev->end - prev->start != PGSIZE)
+            return false;
+          prev->writable = true;
+        }
+      if (prev->read_bytes < prev_ofs + page_read_bytes)
+        prev->read_bytes = prev_ofs + page_read_bytes;
 
-      page_alloc_with_file (thread_current ()->page_table, upage, file, ofs, page_read_bytes, 
-                            page_zero_bytes, writable);
-      /* Advance. */
       read_bytes -= page_read_bytes;
-      zero_bytes -= page_zero_bytes;
-      ofs += page_read_bytes;
+      zero_bytes -= PGSIZE - page_read_bytes;
+      ofs += PGSIZE;
       upage += PGSIZE;
+      if (read_bytes == 0 && zero_bytes == 0)
+        return true;
     }
 
-  return true;
-
+  return vma_create (vmas, upage, read_bytes + zero_bytes, VMA_SEGMENT,
+                     file, ofs, read_bytes, writable) != NULL;
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -573,6 +792,15 @@ setup_stack (const struct arguments *args, void **esp)
       success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
       if (success) {
         *esp = push_args_on_stack (args);
+
+        /* Give the stack page an entry in the page table like any
+           other, so that it can be evicted and fork() copies it. */
+        struct page *p = page_alloc_zeroed (thread_current ()->page_table,
+                                            ((uint8_t *) PHYS_BASE) - PGSIZE);
+        p->kpage = kpage;
+        p->status = IN_FRAME;
+        add_to_pages (kpage, p);
+        frame_set_pinned (kpage, false);
       } else {
         frame_free (kpage, true);
 
@@ -597,23 +825,29 @@ grow_stack (void *vaddr)
     printf ("Couldn't grow stack: frame table is full!\n");
     return false;
   }
+  frame_set_pinned (kpage, true);
 
-  struct page *p = page_alloc_zeroed (thread_current ()->page_table, vaddr);
+  struct hash *pt = thread_current ()->page_table;
+  struct page *p = page_alloc_zeroed (pt, vaddr);
   if (p == NULL) {
     frame_free (kpage, true);
     return false;
   }
-  p->kpage = kpage;
-  p->writable = true;
-  p->status = IN_FRAME;
-  add_to_pages (kpage, p);
 
+  /* P goes on the frame's pages list only once it is mapped, so
+     if mapping fails, it only has to come out of the page table. */
   if (!install_page (p->addr, kpage, true)) {
+    page_dealloc (pt, p);
     frame_free (kpage, true);
-    free (p);
     printf ("Unable to grow stack!\n");
     return false;
   }
+  p->kpage = kpage;
+  p->writable = true;
+  p->status = IN_FRAME;
+  add_to_pages (kpage, p);
+
+  frame_set_pinned (kpage, false);
   return true;
 }
 
@@ -694,22 +928,25 @@ bool load_file_page (struct page *p, void *kpage) {
     }      
   }
 
-  bool file_locked = lock_held_by_current_thread (&filesys_lock);
+  /* A fault during load() already holds the lock for writing.
+     One during a read system call holds it for reading, which
+     rwlock_acquire_read() allows it to take again. */
+  bool file_locked = rwlock_write_held_by_current_thread (&filesys_lock);
   if (!file_locked) {
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_read (&filesys_lock);
   }
 
   /* Load data into the page. */
   if(!load_file (kpage, p)) {
     if (!file_locked) {
-      lock_release (&filesys_lock);
+      rwlock_release_read (&filesys_lock);
     }
     frame_free (kpage, true);
     return false;
   }
 
   if (!file_locked) {
-    lock_release (&filesys_lock);
+    rwlock_release_read (&filesys_lock);
   }
 
   p->kpage = kpage;
@@ -723,28 +960,51 @@ bool load_file_page (struct page *p, void *kpage) {
 }
 
 bool
-load_page(struct hash *pt, uint32_t *pagedir, struct page *p)
+load_page(struct hash *pt, uint32_t *pagedir, struct page *p, bool write)
 {
+  /* If P's frame is being evicted, wait until P is in swap. */
+  frame_wait_paged_out (p);
+
   if (p->status == IN_FRAME) {
     /* Page is already loaded. */
     return true;
   }
 
-  /* Obtain a frame to store the page. */
-  void *kpage = frame_alloc (PAL_USER, p->addr);
+  /* A zero page needs a frame of its own only once it is written.
+     Until then it reads from the shared zero frame, which the
+     first write replaces. */
+  if (p->status == ALL_ZERO) {
+    if (!write) {
+      return frame_map_zero (p);
+    }
+    pagedir_clear_page (pagedir, p->addr);
+  }
+
+  /* Read-only pages of a file, such as program text, can share
+     a frame that another process has already read them into. */
+  bool cacheable = p->status == FILE && !p->writable;
+  if (cacheable && frame_share_file_page (p)) {
+    return true;
+  }
+
+  /* Obtain a frame to store the page, zeroed if the page is new:
+     usually the idle thread has zeroed it already. */
+  void *kpage = frame_alloc (p->status == ALL_ZERO ? PAL_ZERO : PAL_USER,
+                             p->addr);
   if (kpage == NULL) {
     return false;
   }
   frame_set_pinned (kpage, true);
 
   /* Load page data into the frame. */
-  bool writable = true;
+  bool writable = p->writable;
+  size_t readahead_slot = 0;
 
   switch (p->status)
   {
   case ALL_ZERO:
-    /* Zeroed out page. */
-    memset (kpage, 0, PGSIZE);
+    /* Zeroed out page, already cleared by frame_alloc(). */
+    add_to_pages (kpage, p);
     break;
 
   case IN_FRAME:
@@ -753,21 +1013,30 @@ load_page(struct hash *pt, uint32_t *pagedir, struct page *p)
     break;
 
   case SWAPPED:
-    /* Swap in: load the data from the swap disc. */
-    ASSERT ((int) p->swap_slot != -1);
-    swap_in (kpage, p->swap_slot);
+    /* Swap in: decompress the data if it was kept in memory,
+       otherwise load it from the swap disc. */
+    if (!zswap_load (p->zswap, kpage)) {
+      ASSERT ((int) p->swap_slot != -1);
+      readahead_slot = p->swap_slot + 1;
+      swap_in (kpage, p->swap_slot);
+    }
+    p->zswap = NULL;
     add_to_pages (kpage, p);
     p->status = IN_FRAME;
     break;
 
   case FILE:
   case MMAPPED:
-    /* Load page from file into allocated frame. */
-    if (!file_share_page (p)) {
-      return load_file_page (p, kpage);
+    /* Load page from file into allocated frame, and offer it to
+       other processes that map the same read-only page. */
+    if (!load_file_page (p, kpage)) {
+      return false;
     }
-    load_page (pt, pagedir, p);
-    return;
+    if (cacheable) {
+      frame_cache_file_page (kpage, p);
+    }
+    fault_around (pt, p);
+    return true;
 
   default:
     ASSERT (false);
@@ -786,39 +1055,118 @@ load_page(struct hash *pt, uint32_t *pagedir, struct page *p)
   frame_set_pinned (kpage, false);
   pagedir_set_dirty (pagedir, kpage, false);
 
+  if (readahead_slot != 0) {
+    swap_readahead (pt, pagedir, (uint8_t *) p->addr + PGSIZE, readahead_slot);
+  }
+
   return true;
 }
 
-bool file_share_page (struct page *p) {
-  if (p->kpage != NULL) {
-    return false;
+/* Maps in the pages around file page P, which was just faulted
+   in, that lie in P's area within the aligned window of
+   FAULT_AROUND_PAGES pages containing P and are not yet loaded.
+   Pages already in the shared page cache are just mapped; others
+   are read from the file.  These are only a guess at what the
+   process will touch next, so stops as soon as free frames run
+   low. */
+static void
+fault_around (struct hash *pt, struct page *p)
+{
+  struct thread *t = thread_current ();
+  struct vma *vma = p->vma;
+
+  if (vma == NULL || fault_around_pages <= 1) {
+    return;
   }
 
-  // search page table for page pointing to same file 
-  struct hash *pt = thread_current ()->page_table;
-  struct page *temp = malloc (sizeof (struct page));
-  struct hash_elem *e;
-  temp->file = p->file;
-  temp->offset = p->offset;
-  e = hash_find (pt, &temp->hash_elem);
-  free (temp);
-  if (e == NULL) {
-    /* No corresponding file in pt to share with */
-    return false;
+  size_t index = ((uint8_t *) p->addr - vma->start) / PGSIZE;
+  size_t first = index - index % fault_around_pages;
+  uint8_t *upage = vma->start + first * PGSIZE;
+  size_t left = (vma->end - upage) / PGSIZE;
+  size_t cnt = left < fault_around_pages ? left : fault_around_pages;
+
+  for (; cnt > 0; cnt--, upage += PGSIZE) {
+    if (upage == p->addr) {
+      continue;
+    }
+    if (frame_pressure ()) {
+      return;
+    }
+
+    struct page *n = page_from_vma (pt, &t->vmas, upage);
+    if (n == NULL) {
+      return;
+    }
+    if (n->status != FILE && n->status != MMAPPED) {
+      continue;
+    }
+
+    bool cacheable = n->status == FILE && !n->writable;
+    if (cacheable && frame_share_file_page (n)) {
+      continue;
+    }
+
+    void *kpage = frame_alloc (PAL_USER, n->addr);
+    if (kpage == NULL) {
+      return;
+    }
+    frame_set_pinned (kpage, true);
+    if (!load_file_page (n, kpage)) {
+      return;
+    }
+    if (cacheable) {
+      frame_cache_file_page (kpage, n);
+    }
   }
+}
 
-  struct page *s = hash_entry (e, struct page, hash_elem);
-  ASSERT (s != NULL);
+/* Reads in the swapped pages from UPAGE on in the current
+   process's address space that were swapped out to consecutive
+   slots starting at SLOT, as eviction clusters them, up to a
+   cluster's worth, with a single read.  These are only a guess
+   at what the process will touch next, so stops as soon as free
+   frames run low. */
+static void
+swap_readahead (struct hash *pt, uint32_t *pagedir, uint8_t *upage,
+                size_t slot)
+{
+  struct page *pages[SWAP_CLUSTER - 1];
+  void *kpages[SWAP_CLUSTER - 1];
+  size_t cnt, i;
+
+  for (cnt = 0; cnt < SWAP_CLUSTER - 1; cnt++, upage += PGSIZE) {
+    struct page *p = is_user_vaddr (upage) ? page_lookup (pt, upage) : NULL;
+    if (p == NULL || p->status != SWAPPED || p->zswap != NULL
+        || p->swap_slot != slot + cnt || frame_pressure ()) {
+      break;
+    }
 
-  page_install_frame (pt, p->addr, s->kpage);
+    kpages[cnt] = frame_alloc (PAL_USER, p->addr);
+    if (kpages[cnt] == NULL) {
+      break;
+    }
+    frame_set_pinned (kpages[cnt], true);
+    pages[cnt] = p;
+  }
+  if (cnt == 0) {
+    return;
+  }
 
-  add_to_pages (s->kpage, p);
+  swap_read_cluster (slot, cnt, kpages);
+  for (i = 0; i < cnt; i++) {
+    struct page *p = pages[i];
 
-  if (s->status == IN_FRAME) {
-    return true;
-  } else {
-    p->status = s->status;
-    printf ("SHARED PAGE IS NOT IN FRAME\n");
-    return true;
+    /* A page that cannot be mapped stays in its slot. */
+    if (!install_page (p->addr, kpages[i], p->writable)) {
+      frame_free (kpages[i], true);
+      continue;
+    }
+    swap_drop (p->swap_slot);
+    add_to_pages (kpages[i], p);
+    p->kpage = kpages[i];
+    p->status = IN_FRAME;
+
+    frame_set_pinned (kpages[i], false);
+    pagedir_set_dirty (pagedir, kpages[i], false);
   }
 }
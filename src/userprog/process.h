@@ -1,18 +1,23 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "vm/page.h"
 
 #define MAX_STACK_SIZE 0x200000
 
+/* Pages of a file mapping to map around a faulting one.
+   Set from the kernel command line with -fa. */
+extern unsigned fault_around_pages;
+
 tid_t process_execute (const char *file_name);
+tid_t process_fork (struct intr_frame *);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
 bool grow_stack (void *vaddr);
 bool load_file_page (struct page *p, void *kpage);
-bool load_page(struct hash *pt, uint32_t *pagedir, struct page *p);
-bool file_share_page (struct page *p);
+bool load_page(struct hash *pt, uint32_t *pagedir, struct page *p, bool write);
 
 #endif /* userprog/process.h */
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <round.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -16,7 +17,7 @@
 #include "userprog/mapId.h"
 
 static void syscall_handler (struct intr_frame *);
-static void (*syscall_handlers[20]) (struct intr_frame *);     /* Array of function pointers so syscall handlers. */
+static void (*syscall_handlers[SYS_FORK + 1]) (struct intr_frame *);     /* Array of function pointers so syscall handlers. */
 void exit_with_code (int);
 static void *valid_pointer (void *, struct intr_frame *, bool);
 
@@ -39,11 +40,12 @@ void syscall_tell (struct intr_frame *);
 void syscall_close (struct intr_frame *);
 void syscall_mmap (struct intr_frame *f);
 void syscall_munmap (struct intr_frame *f);
+void syscall_fork (struct intr_frame *);
 
 void
 syscall_init (void) 
 {
-  lock_init (&filesys_lock);
+  rwlock_init (&filesys_lock);
 
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
   
@@ -62,6 +64,7 @@ syscall_init (void)
   syscall_handlers[SYS_CLOSE] = &syscall_close;
   syscall_handlers[SYS_MMAP] = &syscall_mmap;
   syscall_handlers[SYS_MUNMAP] = &syscall_munmap;
+  syscall_handlers[SYS_FORK] = &syscall_fork;
 }
 
 static void
@@ -71,7 +74,8 @@ syscall_handler (struct intr_frame *f)
   /* Call appropriate system call function from system calls array. */
   int syscall_num = *(int *) valid_pointer (f->esp, f, 0);
 
-  if (syscall_num >= SYS_HALT && syscall_num <= SYS_MUNMAP) {
+  if (syscall_num >= SYS_HALT && syscall_num <= SYS_FORK
+      && syscall_handlers[syscall_num] != NULL) {
     syscall_handlers[syscall_num] (f);
   } else {
     exit_with_code (-1);
@@ -159,6 +163,11 @@ syscall_wait (struct intr_frame *f) {
   f->eax = process_wait (*(tid_t*) get_argument (f, 0));
 }
 
+void
+syscall_fork (struct intr_frame *f) {
+  f->eax = process_fork (f);
+}
+
 
 
 
@@ -176,9 +185,9 @@ syscall_create (struct intr_frame *f) {
     exit_with_code (-1);
   }
 
-  lock_acquire (&filesys_lock);
+  rwlock_acquire_write (&filesys_lock);
   bool success = filesys_create (file, initial_size);
-  lock_release (&filesys_lock);
+  rwlock_release_write (&filesys_lock);
 
   f->eax = success;
 }
@@ -186,9 +195,9 @@ syscall_create (struct intr_frame *f) {
 void
 syscall_remove (struct intr_frame *f) {
   const char *file = *(const char**) get_argument (f, 0);
-  lock_acquire (&filesys_lock);
+  rwlock_acquire_write (&filesys_lock);
   bool removed = filesys_remove (file);
-  lock_release (&filesys_lock);
+  rwlock_release_write (&filesys_lock);
   f->eax = removed;
 }
 
@@ -199,7 +208,7 @@ syscall_open (struct intr_frame *f) {
     f->eax = -1;
     return;
   }
-  lock_acquire (&filesys_lock);
+  rwlock_acquire_write (&filesys_lock);
   struct file *file = filesys_open (name);
   
   if (file == NULL) {
@@ -207,7 +216,7 @@ syscall_open (struct intr_frame *f) {
   } else {
     f->eax = assign_fd (file);
   }
-  lock_release (&filesys_lock);
+  rwlock_release_write (&filesys_lock);
 }
 
 void
@@ -216,12 +225,12 @@ syscall_filesize (struct intr_frame *f) {
   if(fd < 2){
     f->eax = 0;
   }else{
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_read (&filesys_lock);
     struct file *file = fd_to_file (fd);
     if (file != NULL) {
       f->eax = (int) file_length (file);
     }
-    lock_release (&filesys_lock);
+    rwlock_release_read (&filesys_lock);
   }
 }
 
@@ -238,12 +247,12 @@ syscall_read (struct intr_frame *f) {
   } else if (fd == 1) {
     f->eax = -1;
   } else {
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_read (&filesys_lock);
     struct file* file = fd_to_file (fd);
     if (file != NULL) {  
       f->eax = file_read (file, buffer, size);
     }
-    lock_release (&filesys_lock);
+    rwlock_release_read (&filesys_lock);
   }
 }
 
@@ -262,12 +271,12 @@ syscall_write (struct intr_frame *f) {
   } else if (fd == 0) {
     f->eax = 0;
   } else {
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_write (&filesys_lock);
     struct file *file = fd_to_file (fd);
     if (file != NULL) {
       f->eax = file_write (file, buffer, size);
     }
-    lock_release (&filesys_lock);
+    rwlock_release_write (&filesys_lock);
   }
 }
 
@@ -276,12 +285,12 @@ syscall_seek (struct intr_frame *f) {
   int fd = *(int*) get_argument (f, 0);
   off_t position = *(off_t*) get_argument (f, 1);
   if (fd > 2) {
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_write (&filesys_lock);
     struct file *file = fd_to_file (fd);
     if (file != NULL) {
       file_seek (file, position);
     }
-    lock_release (&filesys_lock);
+    rwlock_release_write (&filesys_lock);
   }
 }
 
@@ -291,12 +300,12 @@ syscall_tell (struct intr_frame *f) {
   if (fd < 2) {
     f->eax = 0;
   } else {
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_read (&filesys_lock);
     struct file *file = fd_to_file (fd);
     if (file != NULL) {
       f->eax = (unsigned) file_tell (file);
     }
-    lock_release (&filesys_lock);
+    rwlock_release_read (&filesys_lock);
   }
 }
 
@@ -304,7 +313,7 @@ void
 syscall_close (struct intr_frame *f) {
   int fd = *(int*) get_argument (f, 0);
   if(fd > 2){
-    lock_acquire (&filesys_lock);
+    rwlock_acquire_write (&filesys_lock);
     
     struct file *file = fd_to_file (fd);
     if (file != NULL) {
@@ -312,7 +321,7 @@ syscall_close (struct intr_frame *f) {
       file_close (file);
     }
 
-    lock_release (&filesys_lock);
+    rwlock_release_write (&filesys_lock);
   }
 }
 
@@ -336,62 +345,45 @@ void syscall_mmap (struct intr_frame *f){
     return;
   }
   int size = file_length(newFile);
-  if(size == 0){
+  size_t length = ROUND_UP (size, PGSIZE);
+  uint8_t *stack_bottom = (uint8_t *) PHYS_BASE - MAX_STACK_SIZE;
+  /* The mapping may not reach into the region the stack grows in,
+     nor overlap the executable or another mapping. */
+  if(size == 0 || (uint8_t *) addr >= stack_bottom || length > (size_t) (stack_bottom - (uint8_t *) addr)
+     || vma_create(&thread_current ()->vmas,addr,length,VMA_MMAP,newFile,0,size,true) == NULL){
+    file_close(newFile);
     f->eax = -1;
     return;
   }
-  int i;
-  uint32_t read_bytes;
-  uint32_t zero_bytes;
-  for( i = 0; i < size; i = i + PGSIZE){
-    if (i+PGSIZE < size){
-      read_bytes = PGSIZE;
-      zero_bytes = 0;
-    }else{
-      read_bytes = size - i;
-      zero_bytes = PGSIZE - read_bytes;
-    }
-    
-    if(! page_alloc_mmap(thread_current ()->page_table,addr + i,newFile,i,read_bytes,zero_bytes,true)){
-      f->eax = -1;
-      for(i = i - PGSIZE; i >0; i = i - PGSIZE){ 
-        page_dealloc(thread_current ()->page_table,addr + i);
-      }
-      return;
-    }
-  }
   f->eax = assign_mapId(addr);
 }
 
 //void munmap (mapid_t mapid) 
 void syscall_munmap (struct intr_frame *f){
-  lock_acquire(&filesys_lock);
+  rwlock_acquire_write (&filesys_lock);
   int mapid = *(int*) get_argument (f, 0);
   unmmap(mapid);
   remove_mapId(mapid);
-  lock_release(&filesys_lock);
+  rwlock_release_write (&filesys_lock);
   
 }
 
+/* Writes back and unmaps the pages of mapping MAPID.  Only the
+   pages the process has touched exist, so this takes time in
+   proportion to them rather than to the size of the mapping. */
 void unmmap (int mapid){
-  
-  void *addr = mapId_to_file(mapid);
-  struct page *page = page_lookup (thread_current ()->page_table, addr);
-  struct file *file = page->file;
-  int size = file_length(file);
-  for(int i = 0; i < size; i = i + PGSIZE){
-    struct page *page = page_lookup (thread_current ()->page_table, addr+i);
-    file_seek(page->file,page->offset);
-    if(page->status == IN_FRAME && pagedir_is_dirty(page->owner->pagedir,page->addr)){ 
-      
-      file_write(page->file,page->addr,page->read_bytes);
-      
+  struct thread *t = thread_current ();
+  struct vma *vma = vma_find (&t->vmas, mapId_to_file(mapid));
+
+  while(!list_empty(&vma->pages)){
+    struct page *page = list_entry(list_front(&vma->pages), struct page, vma_elem);
+    if(page->status == IN_FRAME && pagedir_is_dirty(page->owner->pagedir,page->addr)){
+      file_write_at(page->file,page->addr,page->read_bytes,page->offset);
     }
-    page_dealloc(thread_current ()->page_table,page);
-    
+    frame_release_page(page);
+    page_dealloc(t->page_table,page);
   }
-  
-  
+  vma_destroy(&t->vmas,vma);
 }
 
 
@@ -1,12 +1,18 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include "threads/synch.h"
 
 
 void syscall_init (void);
 void exit_with_code (int status);
 void file_init(void);
 
-struct lock filesys_lock;
+/* Guards the file system and the file descriptor tables.  Calls
+   that only read file data or a file's size or position take it
+   for reading, so processes reading files run side by side; the
+   position they advance belongs to a file that only the calling
+   process has open.  Everything else takes it for writing. */
+struct rwlock filesys_lock;
 
 #endif /* userprog/syscall.h */
@@ -1,72 +1,155 @@
 #include "frame.h"
+#include <bitmap.h>
 #include "page.h"
 #include "devices/swap.h"
+#include "vm/zswap.h"
 #include "userprog/pagedir.h"
 #include "threads/loader.h"
 #include <stdio.h>
+#include <string.h>
+
+/* Frame table, indexed by the number of the page within the
+   user pool, so that finding the entry for a frame is a matter
+   of arithmetic: it neither searches nor allocates. */
+static struct frame_entry *frame_table;
+static uint8_t *frame_base;             /* First page of the user pool. */
+static size_t frame_cnt;                /* Number of pages in the user pool. */
 
-static struct hash *frame_table;
 static struct list frame_list;
 static struct lock frame_table_lock;
 static struct lock frame_list_lock;
 
+/* Shared page cache: frames holding read-only file data, such
+   as program text, keyed by the inode, offset and length of the
+   data, so that every process running the same program maps the
+   same frames.  Protected by frame_table_lock. */
+static struct hash file_cache;
+
+/* Page of zeros, from the kernel pool, mapped read-only at every
+   zero page that a process has read but not yet written.  It has
+   no frame table entry, so it is never evicted or freed. */
+static void *zero_frame;
+
+/* Signalled, with frame_table_lock held, whenever eviction has
+   finished writing out a run of frames, and so has moved their
+   pages from PAGING_OUT to SWAPPED or FILE. */
+static struct condition paging_out_done;
+
 static struct list_elem *clock_ptr;
 static struct list_elem *reset_ptr;
 
 static bool reset_set = false;
 static int no_of_clock_hand_moves = 0;
 
+/* Number of frame table entries in use. */
+static size_t frames_used;
+
+/* Page-out daemon.  Wakes when fewer than 1/PAGEOUT_LOW of the
+   user frames are free and evicts frames until 1/PAGEOUT_HIGH of
+   them are free again, so that page faults rarely have to evict
+   a frame, and wait for it to be written to swap, themselves. */
+#define PAGEOUT_LOW 32
+#define PAGEOUT_HIGH 16
+static struct semaphore pageout_wakeup;
+static bool pageout_pending;            /* Daemon woken, not yet done? */
+
+static void pageout_daemon (void *aux UNUSED);
+static struct frame_entry *clock_select (void);
+static size_t cluster_gather (struct frame_entry *run[]);
+static void clock_remove (struct frame_entry *);
+static void release_entry (struct frame_entry *, bool free_page);
+static void frame_hand_over (struct frame_entry *);
+static hash_hash_func cache_hash;
+static hash_less_func cache_less;
+static size_t free_frames (void);
+static void wait_paged_out (struct page *);
+
 /* Initialization code for frame table. */
 void
 frame_table_init (void) {
+  size_t i;
+
   lock_init (&frame_table_lock);
   lock_init (&frame_list_lock);
-  frame_table = malloc (sizeof (struct hash));
-  hash_init (frame_table, frame_hash, frame_less_func, NULL);
+  cond_init (&paging_out_done);
   list_init (&frame_list);
+  hash_init (&file_cache, cache_hash, cache_less, NULL);
+  zero_frame = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+
+  frame_base = palloc_user_base ();
+  frame_cnt = palloc_user_page_cnt ();
+  frame_table = calloc (frame_cnt, sizeof *frame_table);
+  if (frame_table == NULL)
+    PANIC ("Not enough memory for frame table.");
+  for (i = 0; i < frame_cnt; i++) {
+    list_init (&frame_table[i].pages);
+    lock_init (&frame_table[i].pages_lock);
+  }
 
   clock_ptr = NULL;
   reset_ptr = NULL;
+
+  sema_init (&pageout_wakeup, 0);
+  thread_create ("pageout", PRI_DEFAULT + 1, pageout_daemon, NULL);
 }
 
-/* Hash function for frame table. */
-unsigned
-frame_hash (const struct hash_elem *e, void *aux UNUSED) {
-  const struct frame_entry *entry = hash_entry (e, struct frame_entry, hash_elem);
-  return hash_bytes (&entry->frame_address, sizeof (entry->frame_address));
+/* Page-out daemon thread.  Runs above the default priority, so
+   that it gets the CPU back from faulting processes as soon as
+   each swap write completes. */
+static void
+pageout_daemon (void *aux UNUSED) {
+  for (;;) {
+    sema_down (&pageout_wakeup);
+    while (free_frames () < frame_cnt / PAGEOUT_HIGH && eviction ())
+      continue;
+    pageout_pending = false;
+  }
 }
 
-/* Comparing function for frame table. */
+/* Returns true if free user frames are running low, in which
+   case the page-out daemon is busy evicting frames and nothing
+   should be read in on speculation. */
 bool
-frame_less_func (const struct hash_elem *e1, const struct hash_elem *e2, void *aux UNUSED) {
-  const struct frame_entry *a = hash_entry (e1, struct frame_entry, hash_elem);
-  const struct frame_entry *b = hash_entry (e2, struct frame_entry, hash_elem);
-  return a->frame_address < b->frame_address;
+frame_pressure (void) {
+  return free_frames () < frame_cnt / PAGEOUT_LOW;
+}
+
+/* Returns the number of user frames not in use. */
+static size_t
+free_frames (void) {
+  return frame_cnt - frames_used;
+}
+
+/* Returns the frame table entry for user page KPAGE, whether or
+   not it is in use, or a null pointer if KPAGE is not in the
+   user pool. */
+static struct frame_entry *
+frame_entry_at (void *kpage) {
+  size_t idx = ((uint8_t *) kpage - frame_base) / PGSIZE;
+
+  if ((uint8_t *) kpage < frame_base || idx >= frame_cnt) {
+    return NULL;
+  }
+  return &frame_table[idx];
 }
 
-/* Creates a new frame table entry, which stores the address of the frame, 
-the process that owns the frame. */
+/* Starts using the frame table entry for KPAGE, which stores the
+address of the frame, the process that owns the frame. */
 struct frame_entry *
-create_entry (void) {
-  struct frame_entry *f = malloc (sizeof (struct frame_entry));
-  list_init(&f->pages);
-  lock_init(&f->pages_lock);
+create_entry (void *kpage) {
+  struct frame_entry *f = frame_entry_at (kpage);
+  ASSERT (f != NULL);
+  ASSERT (f->frame_address == NULL);
 
+  f->frame_address = kpage;
+  list_init (&f->pages);
   f->owner = thread_current ();
+  f->inode = NULL;
+  frames_used++;
   
   return f;
 }
 
-/* Creates a "fake" temporary hash element on the stack,
-containing just enough information for hash_find to find the element we are looking for. */
-struct frame_entry *
-search_elem (void *address) {
-  struct frame_entry *temp_entry;
-  temp_entry = malloc (sizeof (struct frame_entry));
-  temp_entry->frame_address = address;
-  return temp_entry;
-}
-
 /* Frees all resources used by frame table entry
 and removes entry from the frame table. */
 void
@@ -95,7 +178,7 @@ frame_free (void *kpage, bool free_page) {
         e = list_remove (&p->list_elem);
         if (p->kpage == kpage) {
           page_dealloc(thread_current ()->page_table, p);
-          return;
+          break;
         }
       } else {
         e = list_next (e);
@@ -108,37 +191,52 @@ frame_free (void *kpage, bool free_page) {
 
 
   if (!referenced) {
-    /* Deallocate the frame table entry. */
-    hash_delete (frame_table, &frame->hash_elem);
-    /* Remove from list for clock algorithm. */
-    list_remove (&frame->list_elem);
-
-    if (free_page) {
-       palloc_free_page (frame->frame_address);
-    }
-    free (frame);
+    release_entry (frame, free_page);
   } 
   lock_release (&frame_table_lock);
 }
 
-/* Allocates a frame for the given page. */
+/* Removes FRAME from the clock and releases its frame table
+   entry, freeing the page too if FREE_PAGE is true.  Must be
+   called with frame_table_lock held. */
+static void
+release_entry (struct frame_entry *frame, bool free_page) {
+  clock_remove (frame);
+  if (frame->inode != NULL) {
+    hash_delete (&file_cache, &frame->cache_elem);
+    frame->inode = NULL;
+  }
+
+  if (free_page) {
+     palloc_free_page (frame->frame_address);
+  }
+  frame->frame_address = NULL;
+  frames_used--;
+}
+
+/* Allocates a frame for the given page.  Normally there is a
+   free frame, which the page-out daemon keeps topped up; if not,
+   evicts one directly. */
 void *
 frame_alloc (enum palloc_flags flags, void *upage) {
   bool evict_success = false;
 
   void *f_page = palloc_get_page (PAL_USER | flags);
 
-  if(f_page == NULL) {
-    evict_success = eviction (flags);
+  while (f_page == NULL) {
+    if (!eviction ()) {
+      return NULL;
+    }
+    evict_success = true;
+    f_page = palloc_get_page (PAL_USER | flags);
   }
 
   lock_acquire(&frame_table_lock);
 
-  struct frame_entry *new_frame = create_entry ();
-  ASSERT (new_frame != NULL);
+  struct frame_entry *new_frame = create_entry (f_page);
 
   lock_acquire (&frame_list_lock);
-  if (evict_success) {
+  if (evict_success && clock_ptr != NULL) {
     /* If frame was evicted, insert new frame at clock pointer. */
     list_insert (clock_ptr, &new_frame->list_elem);
   } else {
@@ -148,7 +246,6 @@ frame_alloc (enum palloc_flags flags, void *upage) {
   lock_release (&frame_list_lock);
 
   /* Sets new page information (both for page-in and page replacement). */
-  new_frame->frame_address = f_page;
   new_frame->upage = upage;
 
   struct thread *t = thread_current ();
@@ -162,69 +259,215 @@ frame_alloc (enum palloc_flags flags, void *upage) {
     }
   }
 
-  ASSERT (hash_insert (frame_table, &new_frame->hash_elem) == NULL);
   new_frame->pinned = false;
 
+  /* Wake the page-out daemon if free frames are running low. */
+  if (frame_pressure () && !pageout_pending) {
+    pageout_pending = true;
+    sema_up (&pageout_wakeup);
+  }
+
   lock_release (&frame_table_lock);
 
   return f_page;
 }
 
+/* Evicts a frame chosen by the clock algorithm, writing its
+   pages to swap, and frees it.  Returns false if there was no
+   frame that could be evicted.  Pages that compress well are
+   kept in the compressed swap cache rather than written out.
+
+   If the frame holds a single page, the frames holding the pages
+   that follow it in its owner's address space are evicted with
+   it, as far as they may be, into consecutive swap-slots, so
+   that a later fault can read them back in together.
+
+   The frames are unmapped from their pages' owners and pinned
+   under frame_table_lock, but written out without it, so that
+   other threads can allocate and free frames in the meantime.
+   Their pages are PAGING_OUT until the write is done: a thread
+   that needs one of them meanwhile waits in wait_paged_out(). */
 bool
-eviction (enum palloc_flags flags) {
-  /* Page allocation failed -> choose page to evict. */
-  bool evicted = false;
-  struct frame_entry *frame;
+eviction (void) {
+  struct frame_entry *run[SWAP_CLUSTER];
+  void *disk_pages[SWAP_CLUSTER];
+  struct list_elem *e;
+  size_t cnt, disk_cnt, slot, i;
 
   lock_acquire (&frame_table_lock);
+  run[0] = clock_select ();
+  if (run[0] == NULL) {
+    lock_release (&frame_table_lock);
+    return false;
+  }
+  run[0]->pinned = true;
+  cnt = list_size (&run[0]->pages) == 1 ? cluster_gather (run) : 1;
+
+  for (i = 0; i < cnt; i++) {
+    lock_acquire (&run[i]->pages_lock);
+    for (e = list_begin (&run[i]->pages); e != list_end (&run[i]->pages); e = list_next (e)) {
+      struct page *p = list_entry (e, struct page, list_elem);
+      pagedir_clear_page (p->owner->pagedir, p->addr);
+      p->status = PAGING_OUT;
+    }
+    lock_release (&run[i]->pages_lock);
+  }
+  lock_release (&frame_table_lock);
+
+  /* Compress what pages will fit into memory, and swap the rest
+     out, into consecutive slots with a single write if clustered.
+     Pages in the shared page cache are not written anywhere: they
+     are read from their file again when next needed. */
+  disk_cnt = 0;
+  for (i = 0; i < cnt; i++) {
+    if (run[i]->inode != NULL) {
+      continue;
+    }
+    for (e = list_begin (&run[i]->pages); e != list_end (&run[i]->pages); e = list_next (e)) {
+      struct page *p = list_entry (e, struct page, list_elem);
+      p->zswap = zswap_store (p->kpage);
+      if (p->zswap == NULL) {
+        disk_cnt++;
+      }
+    }
+  }
+  slot = disk_cnt > 1 && disk_cnt <= SWAP_CLUSTER ? swap_alloc (disk_cnt) : BITMAP_ERROR;
+  disk_cnt = 0;
+  for (i = 0; i < cnt; i++) {
+    if (run[i]->inode != NULL) {
+      continue;
+    }
+    for (e = list_begin (&run[i]->pages); e != list_end (&run[i]->pages); e = list_next (e)) {
+      struct page *p = list_entry (e, struct page, list_elem);
+      if (p->zswap != NULL) {
+        p->swap_slot = BITMAP_ERROR;
+      } else if (slot != BITMAP_ERROR) {
+        p->swap_slot = slot + disk_cnt;
+        disk_pages[disk_cnt++] = p->kpage;
+      } else {
+        p->swap_slot = swap_out (p->kpage);
+      }
+    }
+  }
+  if (slot != BITMAP_ERROR) {
+    swap_write_cluster (slot, disk_cnt, disk_pages);
+  }
+
+  /* Mark the pages as swapped, or to be read from their file
+     again, wake the threads waiting for them, and remove the
+     frames. */
+  lock_acquire (&frame_table_lock);
+  for (i = 0; i < cnt; i++) {
+    lock_acquire (&run[i]->pages_lock);
+    while (!list_empty (&run[i]->pages)) {
+      struct page *p = list_entry (list_pop_front (&run[i]->pages),
+                                   struct page, list_elem);
+      p->kpage = NULL;
+      p->status = run[i]->inode != NULL ? FILE : SWAPPED;
+    }
+    lock_release (&run[i]->pages_lock);
+    run[i]->pinned = false;
+    release_entry (run[i], true);
+  }
+  cond_broadcast (&paging_out_done, &frame_table_lock);
+  lock_release (&frame_table_lock);
+  return true;
+}
+
+/* Extends RUN, which holds the pinned victim RUN[0], with the
+   frames holding the pages that follow the victim's page in its
+   owner's address space, for as long as each of those frames
+   could be evicted too: it is not pinned, holds only that page,
+   and the page has not been accessed since the clock hand last
+   passed.  Pins the frames added and returns the length of RUN,
+   at most SWAP_CLUSTER.  Must be called with frame_table_lock
+   held. */
+static size_t
+cluster_gather (struct frame_entry *run[]) {
+  struct page *first = list_entry (list_front (&run[0]->pages), struct page, list_elem);
+  struct thread *owner = first->owner;
+  size_t cnt;
+
+  for (cnt = 1; cnt < SWAP_CLUSTER; cnt++) {
+    uint8_t *upage = (uint8_t *) first->addr + cnt * PGSIZE;
+    struct frame_entry *f;
+    struct page *p;
+    void *kpage;
+
+    if (!is_user_vaddr (upage)) {
+      break;
+    }
+    kpage = pagedir_get_page (owner->pagedir, upage);
+    f = kpage != NULL ? frame_find (kpage) : NULL;
+    if (f == NULL || f->pinned || list_size (&f->pages) != 1) {
+      break;
+    }
+    p = list_entry (list_front (&f->pages), struct page, list_elem);
+    if (p->owner != owner || p->addr != upage
+        || pagedir_is_accessed (owner->pagedir, upage)) {
+      break;
+    }
+    f->pinned = true;
+    run[cnt] = f;
+  }
+  return cnt;
+}
+
+/* Moves the clock hand round the frames until it passes one
+   that may be evicted: one that is not pinned, holds user pages
+   and has not been accessed since the hand last passed it.
+   Returns that frame, or a null pointer if two full turns found
+   none.  Must be called with frame_table_lock held. */
+static struct frame_entry *
+clock_select (void) {
+  size_t i;
+
+  if (list_empty (&frame_list)) {
+    return NULL;
+  }
+
+  for (i = 0; i < 2 * frame_cnt; i++) {
+    struct frame_entry *frame;
 
-  while (!evicted) {
     if (clock_ptr == NULL) {
       clock_hand_move ();
     }
-    ASSERT (clock_ptr != NULL);
     frame = list_entry (clock_ptr, struct frame_entry, list_elem);
+    clock_hand_move ();
 
-    if (frame->pinned) {
-      /* Frame is pinned, cannot evict. Move on to next frame. */
-      clock_hand_move ();
+    if (frame->pinned || list_empty (&frame->pages)) {
+      /* Frame is pinned, or holds no user page, cannot evict. */
       continue;
     }
-  
     if (pagedir_is_accessed (frame->owner->pagedir, frame->upage)) {
-      /* Referenced bit set -> give second chance and move clock pointer. */
+      /* Referenced bit set -> give second chance. */
       pagedir_set_accessed (frame->owner->pagedir, frame->upage, false);
-      //pagedir_set_accessed (frame->owner->pagedir, frame->frame_address, false);
-      clock_hand_move ();
-      
-    } else {
-      /* Referenced bit not set -> evict page. */
-      lock_acquire (&frame->pages_lock);
-      struct list_elem *e;
-
-      for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e)) {
-        struct page *p = list_entry (e, struct page, list_elem);
-        ASSERT (p != NULL);
+      continue;
+    }
+    return frame;
+  }
+  return NULL;
+}
 
-        /* Swap out page. */
-        p->swap_slot = swap_out (p->kpage);
-        p->kpage = NULL;
-        p->status = SWAPPED;
-        pagedir_clear_page (p->owner->pagedir, p->addr);
-      }
-      lock_release (&frame->pages_lock);
+/* Removes FRAME from the frame list, first moving either clock
+   hand that points at it on to the next frame. */
+static void
+clock_remove (struct frame_entry *frame) {
+  struct list_elem *next = list_next (&frame->list_elem);
 
-      /* Remove frame. */
-      clock_hand_move ();
-      lock_release (&frame_table_lock);
-      frame_free (frame->frame_address, true);
-
-      void *f_page = palloc_get_page (PAL_USER | flags);
-      evicted = (f_page != NULL);
-      palloc_free_page (f_page);
-    }
+  if (next == list_end (&frame_list)) {
+    next = list_begin (&frame_list);
+  }
+  if (next == &frame->list_elem) {
+    next = NULL;
+  }
+  if (clock_ptr == &frame->list_elem) {
+    clock_ptr = next;
+  }
+  if (reset_ptr == &frame->list_elem) {
+    reset_ptr = next;
   }
-  return evicted;
+  list_remove (&frame->list_elem);
 }
 
 void
@@ -232,7 +475,7 @@ clock_hand_move (void)
 {
   ASSERT (!list_empty(&frame_list));
 
-  if (clock_ptr == NULL || clock_ptr == list_end (&frame_list)) {
+  if (clock_ptr == NULL || list_next (clock_ptr) == list_end (&frame_list)) {
     clock_ptr = list_begin (&frame_list);
   } else {
     clock_ptr = list_next (clock_ptr);
@@ -255,12 +498,18 @@ reset_hand_move (void)
 {
   ASSERT (!list_empty(&frame_list));
 
+  if (reset_ptr == NULL) {
+    reset_ptr = list_begin (&frame_list);
+  }
+
   /* Set reference bit of page pointed to by the second clock hand to 0. */
   struct frame_entry *frame = list_entry (reset_ptr, struct frame_entry, list_elem);
-  pagedir_set_accessed (frame->owner->pagedir, frame->upage, false);
+  if (frame->upage != NULL) {
+    pagedir_set_accessed (frame->owner->pagedir, frame->upage, false);
+  }
   //pagedir_set_accessed (frame->owner->pagedir, frame->frame_address, false);
 
-  if (reset_ptr == NULL || reset_ptr == list_end (&frame_list)) {
+  if (list_next (reset_ptr) == list_end (&frame_list)) {
     reset_ptr = list_begin (&frame_list);
   } else {
     reset_ptr = list_next (reset_ptr);
@@ -272,30 +521,24 @@ frame_set_pinned (void *kpage, bool pinned)
 {
   lock_acquire (&frame_table_lock);
 
-  // hash lookup : a temporary entry
-  struct frame_entry *temp = search_elem (kpage);
-  struct hash_elem *h = hash_find (frame_table, &temp->hash_elem);
-  free (temp);
+  struct frame_entry *f = frame_find (kpage);
 
-  if (h == NULL) {
+  if (f == NULL) {
     printf ("The frame to be pinned/unpinned does not exist\n");
+  } else {
+    f->pinned = pinned;
   }
 
-  struct frame_entry *f;
-  f = hash_entry(h, struct frame_entry, hash_elem);
-
-  f->pinned = pinned;
-
   lock_release (&frame_table_lock);
 }
 
+/* Returns the frame table entry for KPAGE, or a null pointer if
+   KPAGE is not an allocated user frame. */
 struct frame_entry *
 frame_find (void *kpage) {
-  struct frame_entry *temp_entry = search_elem (kpage);
-  struct hash_elem *e = hash_find (frame_table, &temp_entry->hash_elem);
-  free (temp_entry); 
+  struct frame_entry *f = frame_entry_at (kpage);
 
-  return e != NULL ? hash_entry (e, struct frame_entry, hash_elem) : NULL;
+  return f != NULL && f->frame_address != NULL ? f : NULL;
 }
 
 void
@@ -306,3 +549,242 @@ add_to_pages (void *kpage, struct page *p) {
     list_push_back (&f->pages, &p->list_elem);
   }
 }
+
+/* Maps page C of the current process, a fork() child's copy of
+   page P of its parent, to the frame that holds P, read-only in
+   both processes so that the first write to either copies it.
+   If P's frame is being evicted, first waits for the write to
+   finish.  Leaves C without a frame if P is not in one, in which
+   case the caller has to copy P from swap.  Returns false if
+   memory runs out. */
+bool
+frame_share (struct page *p, struct page *c) {
+  struct frame_entry *f;
+  bool success = true;
+
+  lock_acquire (&frame_table_lock);
+  wait_paged_out (p);
+  f = p->status == IN_FRAME && p->kpage != NULL ? frame_find (p->kpage) : NULL;
+  if (f != NULL) {
+    lock_acquire (&f->pages_lock);
+    if (pagedir_set_page (c->owner->pagedir, c->addr, f->frame_address, false)) {
+      pagedir_set_writable (p->owner->pagedir, p->addr, false);
+      c->kpage = f->frame_address;
+      c->status = IN_FRAME;
+      list_push_back (&f->pages, &c->list_elem);
+    } else {
+      success = false;
+    }
+    lock_release (&f->pages_lock);
+  }
+  lock_release (&frame_table_lock);
+
+  return success;
+}
+
+/* Handles a write to page P of the current process, which is
+   mapped read-only because it shares its frame with another
+   process since fork().  Copies the frame into one of P's own,
+   or, if no other page shares it any more, just lets P write to
+   it.  Returns false if there is no memory for the copy. */
+bool
+frame_copy_on_write (struct page *p) {
+  uint32_t *pd = thread_current ()->pagedir;
+  struct frame_entry *f, *copy;
+  void *kpage;
+  bool copied = false;
+
+  kpage = frame_alloc (PAL_USER, p->addr);
+  if (kpage == NULL) {
+    return false;
+  }
+
+  lock_acquire (&frame_table_lock);
+  copy = frame_find (kpage);
+
+  /* If P was evicted while allocating, or is being evicted, the
+     write faults again once it is gone, and swaps a private copy
+     of P back in. */
+  f = p->status == IN_FRAME && p->kpage != NULL ? frame_find (p->kpage) : NULL;
+  if (f != NULL && !f->pinned) {
+    lock_acquire (&f->pages_lock);
+    if (list_size (&f->pages) == 1) {
+      pagedir_set_writable (pd, p->addr, true);
+    } else {
+      memcpy (kpage, f->frame_address, PGSIZE);
+      list_remove (&p->list_elem);
+      if (f->owner == p->owner && f->upage == p->addr) {
+        frame_hand_over (f);
+      }
+      pagedir_clear_page (pd, p->addr);
+      pagedir_set_page (pd, p->addr, kpage, true);
+      p->kpage = kpage;
+      list_push_back (&copy->pages, &p->list_elem);
+      copied = true;
+    }
+    lock_release (&f->pages_lock);
+  }
+  lock_release (&frame_table_lock);
+
+  if (!copied) {
+    frame_free (kpage, true);
+  }
+  return true;
+}
+
+/* Takes page P of the current process, which is being destroyed,
+   off the frame that holds it, if any, and unmaps it.  Frees the
+   frame if no other page shares it. */
+void
+frame_release_page (struct page *p) {
+  struct frame_entry *f;
+
+  if (p->status == ALL_ZERO) {
+    /* P may be mapped to the zero frame. */
+    pagedir_clear_page (p->owner->pagedir, p->addr);
+    return;
+  }
+
+  /* Wait for any eviction of the frame to finish, after which P
+     is in swap instead. */
+  lock_acquire (&frame_table_lock);
+  wait_paged_out (p);
+  f = p->status == IN_FRAME && p->kpage != NULL ? frame_find (p->kpage) : NULL;
+
+  if (f != NULL) {
+    lock_acquire (&f->pages_lock);
+    list_remove (&p->list_elem);
+    pagedir_clear_page (p->owner->pagedir, p->addr);
+    p->kpage = NULL;
+    if (list_empty (&f->pages)) {
+      lock_release (&f->pages_lock);
+      release_entry (f, true);
+    } else {
+      if (f->owner == p->owner) {
+        frame_hand_over (f);
+      }
+      lock_release (&f->pages_lock);
+    }
+  }
+  lock_release (&frame_table_lock);
+}
+
+/* Waits until page P is not PAGING_OUT, that is, until any
+   eviction that is writing out P's frame has finished. */
+void
+frame_wait_paged_out (struct page *p) {
+  lock_acquire (&frame_table_lock);
+  wait_paged_out (p);
+  lock_release (&frame_table_lock);
+}
+
+/* Waits until page P is not PAGING_OUT.  Must be called with
+   frame_table_lock held, which it releases while it waits. */
+static void
+wait_paged_out (struct page *p) {
+  while (p->status == PAGING_OUT) {
+    cond_wait (&paging_out_done, &frame_table_lock);
+  }
+}
+
+/* Maps zero page P of the current process, which the process
+   is reading, to the shared zero frame, read-only.  The first
+   write to P faults again and gives it a frame of its own.
+   Returns false if memory runs out. */
+bool
+frame_map_zero (struct page *p) {
+  ASSERT (p->status == ALL_ZERO);
+
+  return pagedir_set_page (p->owner->pagedir, p->addr, zero_frame, false);
+}
+
+/* Makes the first page left in FRAME's pages list the one whose
+   accessed bit the clock checks, after the page it checked has
+   gone.  Must be called with FRAME's pages_lock held. */
+static void
+frame_hand_over (struct frame_entry *frame) {
+  struct page *p = list_entry (list_front (&frame->pages), struct page, list_elem);
+
+  frame->owner = p->owner;
+  frame->upage = p->addr;
+}
+
+/* Maps read-only file page P of the current process to the frame
+   in the shared page cache that holds the same data, if there is
+   one.  Returns true if successful. */
+bool
+frame_share_file_page (struct page *p) {
+  struct frame_entry key;
+  struct frame_entry *f = NULL;
+  struct hash_elem *e;
+  bool shared = false;
+
+  key.inode = file_get_inode (p->file);
+  key.offset = p->offset;
+  key.read_bytes = p->read_bytes;
+
+  lock_acquire (&frame_table_lock);
+  e = hash_find (&file_cache, &key.cache_elem);
+  if (e != NULL) {
+    f = hash_entry (e, struct frame_entry, cache_elem);
+  }
+  if (f != NULL && !f->pinned) {
+    lock_acquire (&f->pages_lock);
+    if (pagedir_set_page (p->owner->pagedir, p->addr, f->frame_address, false)) {
+      p->kpage = f->frame_address;
+      p->status = IN_FRAME;
+      list_push_back (&f->pages, &p->list_elem);
+      shared = true;
+    }
+    lock_release (&f->pages_lock);
+  }
+  lock_release (&frame_table_lock);
+
+  return shared;
+}
+
+/* Adds the frame at KPAGE, into which read-only file page P has
+   just been read, to the shared page cache, unless the cache
+   already has a frame with the same data, or the frame is
+   already being evicted. */
+void
+frame_cache_file_page (void *kpage, struct page *p) {
+  struct frame_entry *f;
+
+  lock_acquire (&frame_table_lock);
+  f = frame_find (kpage);
+  if (f != NULL && !f->pinned && f->inode == NULL && p->kpage == kpage) {
+    f->inode = file_get_inode (p->file);
+    f->offset = p->offset;
+    f->read_bytes = p->read_bytes;
+    if (hash_insert (&file_cache, &f->cache_elem) != NULL) {
+      f->inode = NULL;
+    }
+  }
+  lock_release (&frame_table_lock);
+}
+
+/* Returns a hash of the file data that frame F caches. */
+static unsigned
+cache_hash (const struct hash_elem *e, void *aux UNUSED) {
+  const struct frame_entry *f = hash_entry (e, struct frame_entry, cache_elem);
+
+  return hash_bytes (&f->inode, sizeof f->inode) ^ hash_int (f->offset);
+}
+
+/* Returns true if the file data frame A caches precedes that of
+   frame B. */
+static bool
+cache_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED) {
+  const struct frame_entry *a = hash_entry (a_, struct frame_entry, cache_elem);
+  const struct frame_entry *b = hash_entry (b_, struct frame_entry, cache_elem);
+
+  if (a->inode != b->inode) {
+    return a->inode < b->inode;
+  }
+  if (a->offset != b->offset) {
+    return a->offset < b->offset;
+  }
+  return a->read_bytes < b->read_bytes;
+}
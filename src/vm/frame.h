@@ -4,6 +4,7 @@
 #include <debug.h>
 #include <hash.h>
 #include <list.h>
+#include "filesys/off_t.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
@@ -11,6 +12,10 @@
 #include "threads/thread.h"
 #include "vm/page.h"
 
+struct page;
+
+/* Frame table entry, one for each page in the user pool.  An
+   entry is in use while its frame_address is nonnull. */
 struct frame_entry
 {
     void *frame_address;
@@ -21,23 +26,26 @@ struct frame_entry
 
     bool pinned;
     struct thread *owner;
-    struct hash_elem hash_elem;
     struct list_elem list_elem;
+
+    /* Read-only file data the frame holds for any process that
+       maps it, if INODE is nonnull.  See frame_cache_file_page(). */
+    struct inode *inode;
+    off_t offset;
+    uint32_t read_bytes;
+    struct hash_elem cache_elem;
 };
 
 void frame_table_init (void);
 
-unsigned frame_hash (const struct hash_elem *h, void *aux UNUSED);
-bool frame_less_func (const struct hash_elem *e1, const struct hash_elem *e2, void *aux UNUSED);
-
 void *frame_alloc (enum palloc_flags flags, void *upage);
 void frame_free (void *kpage, bool free_page);
 
-struct frame_entry *create_entry (void);
-struct frame_entry *search_elem (void *address);
+struct frame_entry *create_entry (void *kpage);
 void remove_frame (void *frame);
 
-bool eviction (enum palloc_flags flags);
+bool eviction (void);
+bool frame_pressure (void);
 void clock_hand_move (void);
 void reset_hand_move (void);
 
@@ -46,4 +54,13 @@ void frame_set_pinned (void *kpage, bool pinned);
 struct frame_entry *frame_find (void *kpage);
 void add_to_pages (void *kpage, struct page *p);
 
+bool frame_share (struct page *p, struct page *c);
+bool frame_copy_on_write (struct page *p);
+void frame_release_page (struct page *p);
+void frame_wait_paged_out (struct page *p);
+bool frame_map_zero (struct page *p);
+
+bool frame_share_file_page (struct page *p);
+void frame_cache_file_page (void *kpage, struct page *p);
+
 #endif /* vm/frame.h */
@@ -1,4 +1,5 @@
 #include "vm/page.h"
+#include <bitmap.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -10,6 +11,7 @@
 #include "userprog/syscall.h"
 
 static void page_destroy (struct hash_elem *e, void *aux UNUSED);
+static void page_forget (struct page *p);
 static struct lock unload_lock;
 
 unsigned
@@ -36,15 +38,25 @@ page_destroy (struct hash_elem *e, void *aux UNUSED)
 {
   struct page *p = hash_entry (e, struct page, hash_elem);
 
-  /* TODO: Lock frame or page? */
+  frame_release_page (p);
+  page_forget (p);
+  free (p);
+}
 
-  if (p->status == SWAPPED){
-    //TODO: swap_drop
+/* Drops P's copy in swap, if any, and removes P from its area. */
+static void
+page_forget (struct page *p)
+{
+  if (p->status == SWAPPED && p->zswap != NULL) {
+    zswap_drop (p->zswap);
+  } else if (p->status == SWAPPED) {
     ASSERT ((int) p->swap_slot != -1);
     swap_drop(p->swap_slot);
   }
 
-  free (p);
+  if (p->vma != NULL) {
+    list_remove (&p->vma_elem);
+  }
 }
 
 /* Destroys the current process's page table. */
@@ -68,25 +80,83 @@ page_dealloc (struct hash *pt, struct page *p)
     }
   }
 
+  page_forget (p);
   free (p);
 }
 
 struct page *
 page_lookup (struct hash *pt, const void *addr)
 {
-  struct page *temp = malloc (sizeof (struct page));
+  struct page temp;
   struct hash_elem *e;
 
-  temp->addr = pg_round_down (addr);
-  e = hash_find (pt, &temp->hash_elem);
+  temp.addr = pg_round_down (addr);
+  e = hash_find (pt, &temp.hash_elem);
 
-  free (temp);
   return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
 }
 
+/* Returns the page containing ADDR in PT, the current process's
+   page table.  If the process has not touched the page before,
+   creates it from the area in VMAS that covers ADDR.  Returns a
+   null pointer if there is no such area, or memory runs out. */
+struct page *
+page_from_vma (struct hash *pt, struct rb_tree *vmas, const void *addr)
+{
+  struct page *p = page_lookup (pt, addr);
+  if (p != NULL) {
+    return p;
+  }
+
+  struct vma *vma = vma_find (vmas, addr);
+  if (vma == NULL) {
+    return NULL;
+  }
+
+  p = malloc (sizeof *p);
+  if (p == NULL) {
+    return NULL;
+  }
+
+  uint8_t *upage = pg_round_down (addr);
+  uint32_t ofs = upage - vma->start;
+
+  p->addr = upage;
+  p->kpage = NULL;
+  p->dirty = false;
+  p->writable = vma->writable;
+  p->owner = thread_current ();
+  p->file = vma->file;
+  p->offset = vma->offset + ofs;
+  p->read_bytes = 0;
+  if (ofs < vma->read_bytes) {
+    p->read_bytes = vma->read_bytes - ofs < PGSIZE
+                    ? vma->read_bytes - ofs : PGSIZE;
+  }
+  p->zero_bytes = PGSIZE - p->read_bytes;
+  if (vma->kind == VMA_MMAP) {
+    p->status = MMAPPED;
+  } else {
+    p->status = p->read_bytes > 0 ? FILE : ALL_ZERO;
+  }
+  p->swap_slot = BITMAP_ERROR;
+  p->zswap = NULL;
+  p->vma = vma;
+  p->list_elem.prev = NULL;
+  p->list_elem.next = NULL;
+  list_push_back (&vma->pages, &p->vma_elem);
+
+  ASSERT (hash_insert (pt, &p->hash_elem) == NULL);
+
+  return p;
+}
+
 struct page *
 page_alloc_zeroed (struct hash *pt, void *vaddr) {
   struct page *p = malloc (sizeof (struct page));
+  if (p == NULL) {
+    return NULL;
+  }
 
   p->addr = vaddr;
   p->kpage = NULL;
@@ -95,104 +165,63 @@ page_alloc_zeroed (struct hash *pt, void *vaddr) {
   p->kpage = NULL;
   p->read_bytes = 0;
   p->zero_bytes = PGSIZE;
+  p->file = NULL;
   p->writable = true;
   p->owner = thread_current ();
+  p->vma = NULL;
+  p->list_elem.prev = NULL;
+  p->list_elem.next = NULL;
 
   ASSERT (hash_insert (pt, &p->hash_elem) == NULL);
 
   return p;
 }
 
-bool
-page_set_dirty (struct hash *pt, void *vaddr, bool dirty) {
-  struct page *p = page_lookup (pt, vaddr);
-  if (p == NULL) {
-    return false;
-  }
-
-  p->dirty = p->dirty || dirty;
-  return true;
-}
-
-/* Creates a supplemental page table for a file page
-   Takes the user virtual address, file, file offset, whether it is writable,
-   the number of bytes to read and its page type 
-   Returns false if memory allocation fails or duplicate MMAP created */
-bool 
-page_alloc_with_file (struct hash *pt, void *upage, struct file *file, off_t offset, 
-                      uint32_t read_bytes, uint32_t zero_bytes, bool writable)
+/* Adds to PT, the current process's page table, a copy of page
+   P of another process, belonging to VMA, the current process's
+   copy of P's area, or to no area if VMA is null.  The
+   copy has the same contents as P only if P is not yet loaded;
+   otherwise it starts out as a zeroed page, for the caller to
+   give a frame with P's contents.  Returns the copy, or a null
+   pointer if memory runs out. */
+struct page *
+page_copy (struct hash *pt, const struct page *p, struct vma *vma)
 {
-  /* Check if virtual page already allocated */
-  struct page *p = page_lookup(pt, upage);
-  
-  if (p != NULL) {
-    /* Update metadata if load_segment is loading same page twice */
-    ////printf("loading same page twice\n");
-    size_t new_read_bytes = p->read_bytes > read_bytes ? p->read_bytes : read_bytes;
-
-    p->read_bytes = new_read_bytes;
-    p->zero_bytes = PGSIZE - new_read_bytes;
-    p->offset = offset;
-    p->writable = p->writable || writable;
-    p->owner = thread_current ();
-
-    return true;
+  struct page *c = malloc (sizeof *c);
+  if (c == NULL) {
+    return NULL;
   }
 
-  /* Creates new table entry with given values if one cannot be found */
-  p = (struct page *) malloc (sizeof (struct page));
-  if (p == NULL) {
-    /* malloc failed */
-    return false;
+  *c = *p;
+  c->owner = thread_current ();
+  c->file = vma != NULL ? vma->file : NULL;
+  c->kpage = NULL;
+  c->zswap = NULL;
+  c->swap_slot = BITMAP_ERROR;
+  c->list_elem.prev = NULL;
+  c->list_elem.next = NULL;
+  if (c->status == IN_FRAME || c->status == PAGING_OUT
+      || c->status == SWAPPED) {
+    c->status = ALL_ZERO;
   }
-
-  p->file = file;
-  p->offset = offset;
-  p->read_bytes = read_bytes;
-  p->zero_bytes = zero_bytes;
-  p->kpage = NULL;
-  p->addr = upage;
-  p->owner = thread_current();
-  p->dirty = false;
-  p->writable = writable;
-  p->status = FILE;
-    
-  if (hash_insert (pt, &p->hash_elem) != NULL) {
-    printf ("inserting already existing page in alloc_file\n");
-    free (p);
+  c->vma = vma;
+  if (vma != NULL) {
+    list_push_back (&vma->pages, &c->vma_elem);
   }
 
-  return true;
+  ASSERT (hash_insert (pt, &c->hash_elem) == NULL);
+
+  return c;
 }
 
-bool 
-page_alloc_mmap (struct hash *pt, void *upage, struct file *file, off_t offset, 
-                      uint32_t read_bytes, uint32_t zero_bytes, bool writable)
-{
-  /* Check if virtual page already allocated */
-  struct page *p = page_lookup(pt, upage);
-  
-  if (p != NULL) {
+bool
+page_set_dirty (struct hash *pt, void *vaddr, bool dirty) {
+  struct page *p = page_lookup (pt, vaddr);
+  if (p == NULL) {
     return false;
   }
 
-  /* Creates new table entry with given values if one cannot be found */
-  p = (struct page *) malloc (sizeof (struct page));
-  ASSERT (p != NULL);
-
-  p->file = file;
-  p->offset = offset;
-  p->read_bytes = read_bytes;
-  p->zero_bytes = zero_bytes;
-  p->kpage = NULL;
-  p->addr = upage;
-  p->owner = thread_current();
-  p->dirty = false;
-  p->writable = writable;
-  p->status = MMAPPED;
-    
-  ASSERT (hash_insert (pt, &p->hash_elem) == NULL);
-
+  p->dirty = p->dirty || dirty;
   return true;
 }
 
@@ -219,12 +248,12 @@ page_install_frame (struct hash *pt, void *upage, void *kpage)
 bool
 load_file (void *kpage, struct page *p)
 {
-  file_seek (p->file, p->offset);
-
-  /* Load data into the page. */
-  if (file_read (p->file, kpage, p->read_bytes) != (int) p->read_bytes) {
+  /* Load data into the page.  file_read_at() leaves the file's
+     position alone, so a fault in the middle of a read system
+     call on the same file does not disturb it. */
+  if (file_read_at (p->file, kpage, p->read_bytes, p->offset)
+      != (int) p->read_bytes) {
     printf ("load_file did not read enough bytes\n");
-    lock_release (&filesys_lock);
     return false;
   }
   
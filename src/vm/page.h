@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <hash.h>
 #include "devices/swap.h"
+#include "vm/zswap.h"
+#include "vm/vma.h"
 #include "threads/palloc.h"
 #include "filesys/file.h"
 #include "vm/frame.h"
@@ -14,6 +16,7 @@ enum page_status
   {
     ALL_ZERO,       /* Zeroed page (new page). */
     IN_FRAME,          /* Frame allocated to page. */
+    PAGING_OUT,     /* Frame being written out by eviction. */
     SWAPPED,        /* Page is swapped (in swap slot). */
     FILE,
     MMAPPED     
@@ -42,6 +45,10 @@ struct page
     uint32_t zero_bytes;         
 
     size_t swap_slot;
+    struct zswap_entry *zswap;  /* Compressed copy, if swapped to memory. */
+
+    struct vma *vma;            /* Area the page belongs to, or null. */
+    struct list_elem vma_elem;  /* Element in the area's page list. */
   };
 
 unsigned page_hash (const struct hash_elem *e, void *aux UNUSED);
@@ -51,14 +58,13 @@ void page_table_destroy (void);
 void page_dealloc (struct hash *pt, struct page *p);
 
 struct page * page_lookup (struct hash *pt, const void *addr);
+struct page *page_from_vma (struct hash *pt, struct rb_tree *vmas,
+                            const void *addr);
 
 struct page * page_alloc_zeroed (struct hash *pt, void *vaddr);
+struct page *page_copy (struct hash *pt, const struct page *p, struct vma *vma);
 bool page_set_dirty (struct hash *pt, void *vaddr, bool dirty);
 
-bool page_alloc_with_file (struct hash *pt, void *upage, struct file *file, off_t offset, 
-                      uint32_t read_bytes, uint32_t zero_bytes, bool writable);
-bool page_alloc_mmap (struct hash *pt, void *upage, struct file *file, off_t offset, 
-                      uint32_t read_bytes, uint32_t zero_bytes, bool writable);
 bool page_install_frame (struct hash *pt, void *upage, void *kpage);
 
 bool load_file (void *kpage, struct page *p);
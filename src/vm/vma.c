@@ -0,0 +1,124 @@
+#include "vm/vma.h"
+#include <debug.h>
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+
+static bool vma_less (const struct rb_elem *, const struct rb_elem *,
+                      void *aux);
+
+/* Initializes AREAS as an empty set of virtual memory areas. */
+void
+vma_init (struct rb_tree *areas)
+{
+  rb_init (areas, vma_less, NULL);
+}
+
+/* Adds to AREAS an area of SIZE bytes at START, of the given
+   KIND, mapping READ_BYTES bytes of FILE from OFFSET on, and
+   zeros after them.  Returns the new area, or a null pointer if
+   it would overlap an existing one or memory runs out. */
+struct vma *
+vma_create (struct rb_tree *areas, void *start, size_t size,
+            enum vma_kind kind, struct file *file, off_t offset,
+            uint32_t read_bytes, bool writable)
+{
+  struct vma *vma;
+
+  ASSERT (pg_ofs (start) == 0);
+  ASSERT (size % PGSIZE == 0);
+  ASSERT (read_bytes <= size);
+
+  if (size == 0 || vma_overlaps (areas, start, (uint8_t *) start + size))
+    return NULL;
+
+  vma = malloc (sizeof *vma);
+  if (vma == NULL)
+    return NULL;
+  vma->start = start;
+  vma->end = (uint8_t *) start + size;
+  vma->kind = kind;
+  vma->file = file;
+  vma->offset = offset;
+  vma->read_bytes = read_bytes;
+  vma->writable = writable;
+  list_init (&vma->pages);
+  rb_insert (areas, &vma->elem);
+  return vma;
+}
+
+/* Returns the area in AREAS that contains ADDR, or a null pointer
+   if there is none. */
+struct vma *
+vma_find (const struct rb_tree *areas, const void *addr)
+{
+  const uint8_t *a = addr;
+  struct rb_elem *e = areas->root;
+
+  while (e != NULL)
+    {
+      struct vma *vma = rb_entry (e, struct vma, elem);
+      if (a < vma->start)
+        e = e->left;
+      else if (a >= vma->end)
+        e = e->right;
+      else
+        return vma;
+    }
+  return NULL;
+}
+
+/* Returns true if any area in AREAS overlaps the range from
+   START up to but not including END. */
+bool
+vma_overlaps (const struct rb_tree *areas, const void *start,
+              const void *end)
+{
+  const uint8_t *s = start, *t = end;
+  struct rb_elem *e = areas->root;
+
+  while (e != NULL)
+    {
+      struct vma *vma = rb_entry (e, struct vma, elem);
+      if (t <= vma->start)
+        e = e->left;
+      else if (s >= vma->end)
+        e = e->right;
+      else
+        return true;
+    }
+  return false;
+}
+
+/* Removes VMA from AREAS and frees it.  The caller must already
+   have destroyed the area's pages. */
+void
+vma_destroy (struct rb_tree *areas, struct vma *vma)
+{
+  ASSERT (list_empty (&vma->pages));
+
+  rb_remove (areas, &vma->elem);
+  free (vma);
+}
+
+/* Frees every area in AREAS.  The pages of the areas must
+   already have been destroyed. */
+void
+vma_destroy_all (struct rb_tree *areas)
+{
+  while (!rb_empty (areas))
+    {
+      struct vma *vma = rb_entry (rb_min (areas), struct vma, elem);
+      vma_destroy (areas, vma);
+    }
+}
+
+/* Orders areas by address. */
+static bool
+vma_less (const struct rb_elem *a_, const struct rb_elem *b_,
+          void *aux UNUSED)
+{
+  const struct vma *a = rb_entry (a_, struct vma, elem);
+  const struct vma *b = rb_entry (b_, struct vma, elem);
+
+  return a->start < b->start;
+}
@@ -0,0 +1,50 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+
+#include <list.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+/* What a virtual memory area maps. */
+enum vma_kind
+  {
+    VMA_SEGMENT,    /* Executable segment: private to the process. */
+    VMA_MMAP        /* Memory-mapped file: written back on munmap. */
+  };
+
+/* Virtual memory area: a contiguous, page-aligned range of a
+   process's address space backed by a file.  The first
+   READ_BYTES bytes come from FILE starting at OFFSET, and the
+   rest are zero.
+
+   A process's areas do not overlap, and are kept in a red-black
+   tree ordered by address.  A struct page is only created for
+   each page of an area once the process touches it, and is kept
+   in the area's PAGES list from then on. */
+struct vma
+  {
+    uint8_t *start;             /* First byte, page-aligned. */
+    uint8_t *end;               /* Byte after the last, page-aligned. */
+    enum vma_kind kind;
+    struct file *file;          /* File mapped. */
+    off_t offset;               /* File offset of START. */
+    uint32_t read_bytes;        /* Bytes read from FILE. */
+    bool writable;              /* May the process write the pages? */
+    struct rb_elem elem;        /* Element in the process's tree. */
+    struct list pages;          /* Pages created so far. */
+  };
+
+void vma_init (struct rb_tree *);
+struct vma *vma_create (struct rb_tree *, void *start, size_t size,
+                        enum vma_kind, struct file *, off_t offset,
+                        uint32_t read_bytes, bool writable);
+struct vma *vma_find (const struct rb_tree *, const void *addr);
+bool vma_overlaps (const struct rb_tree *, const void *start,
+                   const void *end);
+void vma_destroy (struct rb_tree *, struct vma *);
+void vma_destroy_all (struct rb_tree *);
+
+#endif /* vm/vma.h */
@@ -0,0 +1,433 @@
+#include "vm/zswap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Pages are kept in the pool in chunks of ZSWAP_CHUNK bytes, and
+   a compressed page occupies consecutive chunks of one pool
+   page. */
+#define ZSWAP_CHUNK 64
+#define ZSWAP_CHUNKS (PGSIZE / ZSWAP_CHUNK)
+
+/* Pages that do not compress to at most this many bytes are not
+   worth keeping in memory, and go to the swap device. */
+#define ZSWAP_MAX_SIZE (PGSIZE / 2)
+
+/* The pool grows to at most 1/ZSWAP_POOL_FRACTION as many pages
+   as there are in the user pool. */
+#define ZSWAP_POOL_FRACTION 4
+
+/* A kernel page in the pool. */
+struct zpool_page
+  {
+    struct list_elem elem;      /* Element in zpool. */
+    uint8_t *base;              /* The kernel page. */
+    struct bitmap *used;        /* Chunks in use. */
+    size_t free_chunks;         /* Number of chunks not in use. */
+  };
+
+/* A page held in the pool.  A page whose words all equal FILL
+   takes up no space in the pool at all, and has a null ZPAGE. */
+struct zswap_entry
+  {
+    struct zpool_page *zpage;   /* Pool page holding the data. */
+    uint16_t chunk;             /* First chunk within ZPAGE. */
+    uint16_t size;              /* Compressed size in bytes. */
+    uint32_t fill;              /* Word repeated through the page. */
+  };
+
+static struct list zpool;               /* Pages in the pool. */
+static size_t zpool_cnt;                /* Number of pages in zpool. */
+static size_t zpool_max;                /* Limit on zpool_cnt. */
+
+/* Protects the pool, the statistics and the compressor's
+   scratch space below. */
+static struct lock zswap_lock;
+
+/* Statistics. */
+static unsigned long long stored_cnt;   /* Pages compressed into the pool. */
+static unsigned long long filled_cnt;   /* ...of which same-filled. */
+static unsigned long long spilled_cnt;  /* Pages left to the swap device. */
+static unsigned long long orig_bytes;   /* Bytes compressed... */
+static unsigned long long comp_bytes;   /* ...and what they came to. */
+static unsigned long long hit_cnt;      /* Swap-ins from the pool. */
+static unsigned long long miss_cnt;     /* Swap-ins from the device. */
+
+/* LZ compressor.
+
+   A compressed page is a sequence of literal runs, each followed
+   by a match: a copy of earlier output.  Each sequence starts
+   with a byte whose upper 4 bits give the literal run's length
+   and whose lower 4 bits give the match's length less
+   LZ_MIN_MATCH.  A field of 15 is extended by the bytes that
+   follow it, up to and including the first that is not 255.
+   Then come the literals, then the match's 2-byte little-endian
+   distance back into the output and its length extension, if
+   any.  The last sequence has no match, and ends the page.
+
+   Matches are found through a hash table of the last position at
+   which each 4-byte sequence was seen, as in LZ4. */
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+static uint8_t lz_buf[ZSWAP_MAX_SIZE];
+
+static size_t lz_compress (const uint8_t *src, uint8_t *dst, size_t cap);
+static void lz_decompress (const uint8_t *src, uint8_t *dst);
+static bool same_filled (const void *kpage, uint32_t *fill);
+static struct zswap_entry *pool_alloc (size_t size);
+
+/* Sets up the compressed swap cache. */
+void
+zswap_init (void)
+{
+  list_init (&zpool);
+  lock_init (&zswap_lock);
+  zpool_cnt = 0;
+  zpool_max = palloc_user_page_cnt () / ZSWAP_POOL_FRACTION;
+}
+
+/* Compresses the page at KPAGE into the pool.  Returns the pool
+   entry holding it, or a null pointer if the page did not
+   compress well enough or the pool is full, in which case the
+   page has to go to the swap device. */
+struct zswap_entry *
+zswap_store (const void *kpage)
+{
+  struct zswap_entry *e;
+  uint32_t fill;
+  size_t size;
+
+  lock_acquire (&zswap_lock);
+  if (same_filled (kpage, &fill))
+    {
+      e = malloc (sizeof *e);
+      if (e != NULL)
+        {
+          e->zpage = NULL;
+          e->size = 0;
+          e->fill = fill;
+          filled_cnt++;
+        }
+    }
+  else
+    {
+      size = lz_compress (kpage, lz_buf, sizeof lz_buf);
+      e = size != 0 ? pool_alloc (size) : NULL;
+      if (e != NULL)
+        {
+          memcpy (e->zpage->base + e->chunk * ZSWAP_CHUNK, lz_buf, size);
+          orig_bytes += PGSIZE;
+          comp_bytes += size;
+        }
+    }
+
+  if (e != NULL)
+    stored_cnt++;
+  else
+    spilled_cnt++;
+  lock_release (&zswap_lock);
+  return e;
+}
+
+/* Reads the page held in E back into KPAGE and drops E from the
+   pool.  Returns false, without touching KPAGE, if E is a null
+   pointer, meaning the page went to the swap device instead. */
+bool
+zswap_load (struct zswap_entry *e, void *kpage)
+{
+  lock_acquire (&zswap_lock);
+  if (e == NULL)
+    {
+      miss_cnt++;
+      lock_release (&zswap_lock);
+      return false;
+    }
+  hit_cnt++;
+  lock_release (&zswap_lock);
+
+  zswap_copy (e, kpage);
+  zswap_drop (e);
+  return true;
+}
+
+/* Reads the page held in E into KPAGE, leaving E in the pool. */
+void
+zswap_copy (const struct zswap_entry *e, void *kpage)
+{
+  if (e->zpage == NULL)
+    {
+      uint32_t *word = kpage;
+      size_t i;
+
+      for (i = 0; i < PGSIZE / sizeof *word; i++)
+        word[i] = e->fill;
+    }
+  else
+    lz_decompress (e->zpage->base + e->chunk * ZSWAP_CHUNK, kpage);
+}
+
+/* Frees the pool space held by E, and E itself. */
+void
+zswap_drop (struct zswap_entry *e)
+{
+  struct zpool_page *zp = e->zpage;
+
+  lock_acquire (&zswap_lock);
+  if (zp != NULL)
+    {
+      size_t cnt = DIV_ROUND_UP (e->size, ZSWAP_CHUNK);
+
+      bitmap_set_multiple (zp->used, e->chunk, cnt, false);
+      zp->free_chunks += cnt;
+      if (zp->free_chunks == ZSWAP_CHUNKS)
+        {
+          list_remove (&zp->elem);
+          zpool_cnt--;
+          palloc_free_page (zp->base);
+          bitmap_destroy (zp->used);
+          free (zp);
+        }
+    }
+  lock_release (&zswap_lock);
+  free (e);
+}
+
+/* Prints compressed swap cache statistics. */
+void
+zswap_print_stats (void)
+{
+  unsigned long long ratio = comp_bytes != 0 ? orig_bytes * 100 / comp_bytes : 0;
+  unsigned long long loads = hit_cnt + miss_cnt;
+
+  printf ("Zswap: %llu pages stored (%llu same-filled), %llu spilled, "
+          "compression ratio %llu.%02llu\n",
+          stored_cnt, filled_cnt, spilled_cnt, ratio / 100, ratio % 100);
+  printf ("Zswap: %llu hits, %llu misses, hit rate %llu%%\n",
+          hit_cnt, miss_cnt, loads != 0 ? hit_cnt * 100 / loads : 0);
+}
+
+/* Reserves room for SIZE bytes in the pool, growing the pool if
+   need be.  Returns a new entry for it, or a null pointer if the
+   pool is full. */
+static struct zswap_entry *
+pool_alloc (size_t size)
+{
+  size_t cnt = DIV_ROUND_UP (size, ZSWAP_CHUNK);
+  struct zpool_page *zp = NULL;
+  struct zswap_entry *e;
+  struct list_elem *l;
+  size_t chunk = BITMAP_ERROR;
+
+  for (l = list_begin (&zpool); l != list_end (&zpool); l = list_next (l))
+    {
+      zp = list_entry (l, struct zpool_page, elem);
+      if (zp->free_chunks >= cnt)
+        {
+          chunk = bitmap_scan (zp->used, 0, cnt, false);
+          if (chunk != BITMAP_ERROR)
+            break;
+        }
+    }
+
+  if (chunk == BITMAP_ERROR)
+    {
+      if (zpool_cnt >= zpool_max)
+        return NULL;
+      zp = malloc (sizeof *zp);
+      if (zp == NULL)
+        return NULL;
+      zp->base = palloc_get_page (0);
+      zp->used = bitmap_create (ZSWAP_CHUNKS);
+      if (zp->base == NULL || zp->used == NULL)
+        {
+          if (zp->base != NULL)
+            palloc_free_page (zp->base);
+          if (zp->used != NULL)
+            bitmap_destroy (zp->used);
+          free (zp);
+          return NULL;
+        }
+      zp->free_chunks = ZSWAP_CHUNKS;
+      list_push_back (&zpool, &zp->elem);
+      zpool_cnt++;
+      chunk = 0;
+    }
+
+  e = malloc (sizeof *e);
+  if (e == NULL)
+    return NULL;
+  bitmap_set_multiple (zp->used, chunk, cnt, true);
+  zp->free_chunks -= cnt;
+  e->zpage = zp;
+  e->chunk = chunk;
+  e->size = size;
+  return e;
+}
+
+/* Returns true if every word of the page at KPAGE is the same,
+   and stores it in *FILL. */
+static bool
+same_filled (const void *kpage, uint32_t *fill)
+{
+  const uint32_t *word = kpage;
+  size_t i;
+
+  for (i = 1; i < PGSIZE / sizeof *word; i++)
+    if (word[i] != word[0])
+      return false;
+  *fill = word[0];
+  return true;
+}
+
+/* Returns the 4 bytes at P. */
+static inline uint32_t
+lz_read32 (const uint8_t *p)
+{
+  uint32_t v;
+  memcpy (&v, p, sizeof v);
+  return v;
+}
+
+/* Returns the hash table bucket for the 4 bytes V. */
+static inline unsigned
+lz_hash (uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Writes length LEN's extension bytes, if any, to OP, and
+   returns the position just past them. */
+static uint8_t *
+lz_put_len (uint8_t *op, size_t len)
+{
+  if (len >= 15)
+    {
+      for (len -= 15; len >= 255; len -= 255)
+        *op++ = 255;
+      *op++ = len;
+    }
+  return op;
+}
+
+/* Appends to *OP, which must stay below OP_END, a sequence of
+   LIT_LEN literals at LIT followed by a match of MATCH_LEN bytes
+   OFFSET bytes back, or by no match if MATCH_LEN is 0.  Returns
+   false if there is not room. */
+static bool
+lz_emit (uint8_t **op, uint8_t *op_end, const uint8_t *lit, size_t lit_len,
+         size_t offset, size_t match_len)
+{
+  size_t ml = match_len != 0 ? match_len - LZ_MIN_MATCH : 0;
+  uint8_t *p = *op;
+
+  if ((size_t) (op_end - p) < 1 + lit_len / 255 + 1 + lit_len
+                              + 2 + ml / 255 + 1)
+    return false;
+
+  *p++ = ((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15);
+  p = lz_put_len (p, lit_len);
+  memcpy (p, lit, lit_len);
+  p += lit_len;
+  if (match_len != 0)
+    {
+      *p++ = offset & 0xff;
+      *p++ = offset >> 8;
+      p = lz_put_len (p, ml);
+    }
+  *op = p;
+  return true;
+}
+
+/* Compresses the page at SRC into DST, which has room for CAP
+   bytes.  Returns the compressed size, or 0 if it would exceed
+   CAP. */
+static size_t
+lz_compress (const uint8_t *src, uint8_t *dst, size_t cap)
+{
+  const uint8_t *end = src + PGSIZE;
+  const uint8_t *ip = src, *anchor = src;
+  uint8_t *op = dst;
+
+  memset (lz_table, 0, sizeof lz_table);
+  while (ip + LZ_MIN_MATCH <= end)
+    {
+      uint32_t v = lz_read32 (ip);
+      unsigned h = lz_hash (v);
+      const uint8_t *ref = src + lz_table[h];
+      const uint8_t *m, *r;
+
+      lz_table[h] = ip - src;
+      if (ref >= ip || lz_read32 (ref) != v)
+        {
+          ip++;
+          continue;
+        }
+
+      for (m = ip + LZ_MIN_MATCH, r = ref + LZ_MIN_MATCH; m < end && *m == *r;
+           m++, r++)
+        continue;
+      if (!lz_emit (&op, dst + cap, anchor, ip - anchor, ip - ref, m - ip))
+        return 0;
+      ip = anchor = m;
+    }
+
+  if (!lz_emit (&op, dst + cap, anchor, end - anchor, 0, 0))
+    return 0;
+  return op - dst;
+}
+
+/* Reads the extension of a length whose 4-bit field is LEN from
+   *IP, advancing *IP past it, and returns the whole length. */
+static size_t
+lz_get_len (const uint8_t **ip, size_t len)
+{
+  if (len == 15)
+    {
+      uint8_t b;
+      do
+        {
+          b = *(*ip)++;
+          len += b;
+        }
+      while (b == 255);
+    }
+  return len;
+}
+
+/* Decompresses the page compressed at SRC into DST. */
+static void
+lz_decompress (const uint8_t *src, uint8_t *dst)
+{
+  uint8_t *op = dst;
+  uint8_t *end = dst + PGSIZE;
+
+  for (;;)
+    {
+      unsigned token = *src++;
+      size_t len = lz_get_len (&src, token >> 4);
+      const uint8_t *ref;
+
+      memcpy (op, src, len);
+      op += len;
+      src += len;
+      if (op >= end)
+        break;
+
+      ref = op - (src[0] | (src[1] << 8));
+      src += 2;
+      len = lz_get_len (&src, token & 15) + LZ_MIN_MATCH;
+      while (len-- > 0)
+        *op++ = *ref++;
+    }
+  ASSERT (op == end);
+}
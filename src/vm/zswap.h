@@ -0,0 +1,22 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+
+#include <stdbool.h>
+
+/* Compressed swap cache.
+
+   Evicted pages are compressed into a pool of kernel pages and
+   only written to the swap device when they will not fit, so
+   that pages which compress well, above all zero-filled ones,
+   never wait on the disk. */
+
+struct zswap_entry;
+
+void zswap_init (void);
+struct zswap_entry *zswap_store (const void *kpage);
+bool zswap_load (struct zswap_entry *, void *kpage);
+void zswap_copy (const struct zswap_entry *, void *kpage);
+void zswap_drop (struct zswap_entry *);
+void zswap_print_stats (void);
+
+#endif /* vm/zswap.h */